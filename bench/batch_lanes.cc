@@ -0,0 +1,66 @@
+// Compares running one program over many initial values of its variables with one
+// Computer per variant against a single BatchComputer with one lane per variant.
+//
+// g++ -Wall -Wextra -O2 -std=c++17 -I../ooasm_ batch_lanes.cc -o batch_lanes
+// ./batch_lanes 1024 100000
+
+#include "batch.h"
+#include "computer.h"
+#include "ooasm.h"
+#include "program_builder.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char *argv[]) {
+    std::size_t variants = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1024;
+    std::size_t count = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+
+    ooasm::ProgramBuilder b;
+    b.append(b.data("a", b.num(0)));
+    b.append(b.data("b", b.num(0)));
+    for (std::size_t i = 0; i < count; ++i) {
+        auto cell = static_cast<int64_t>(2 + i % 30);
+        switch (i % 4) {
+            case 0:
+                b.append(b.add(b.mem(b.num(cell)), b.mem(b.lea("a"))));
+                break;
+            case 1:
+                b.append(b.sub(b.mem(b.lea("b")), b.mem(b.num(cell))));
+                break;
+            case 2:
+                b.append(b.ones(b.mem(b.num(cell))));
+                break;
+            default:
+                b.append(b.mov(b.mem(b.num(cell)), b.mem(b.lea("b"))));
+                break;
+        }
+    }
+    program p = b.build();
+
+    std::vector<std::vector<int64_t>> initial(variants);
+    for (std::size_t v = 0; v < variants; ++v)
+        initial[v] = {static_cast<int64_t>(v), -static_cast<int64_t>(v)};
+
+    using clock = std::chrono::steady_clock;
+
+    // A Computer per variant would run a program differing only in its declarations,
+    // which changes nothing but the values copied by declare_vars, so the same program is reused.
+    auto start = clock::now();
+    for (std::size_t v = 0; v < variants; ++v) {
+        Computer computer(32);
+        computer.boot(p);
+    }
+    auto sequential = clock::now();
+
+    ooasm::BatchComputer batch(32, variants);
+    batch.boot(p, initial);
+    auto batched = clock::now();
+
+    double instructions = static_cast<double>(variants) * static_cast<double>(count);
+    auto seconds = [](auto d) { return std::chrono::duration<double>(d).count(); };
+    std::cout << "variants=" << variants << " instructions=" << count
+              << " computer_per_variant_s=" << seconds(sequential - start)
+              << " batch_s=" << seconds(batched - sequential)
+              << " batch_instructions_per_s=" << instructions / seconds(batched - sequential) << '\n';
+}
@@ -0,0 +1,67 @@
+// Compares the interpreter with native code on a long straight-line program booted
+// many times. The program mixes arithmetic on static cells, moves through pointers
+// and conditional writes, so the optimizer leaves most of it in place.
+//
+// g++ -Wall -Wextra -O2 -std=c++17 -I../ooasm_ jit.cc -o jit
+// ./jit 100000 1000
+
+#include "computer.h"
+#include "ooasm.h"
+#include "program_builder.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+    program workload(int64_t length) {
+        ooasm::ProgramBuilder b;
+        b.append(b.data("p", b.num(1)));
+        for (int64_t i = 0; i < length; ++i) {
+            int64_t cell = 2 + (i * 7) % 4096;
+            switch (i % 4) {
+                case 0:
+                    b.append(b.add(b.mem(b.num(cell)), b.mem(b.lea("p"))));
+                    break;
+                case 1:
+                    b.append(b.sub(b.mem(b.num(cell)), b.num(3)));
+                    break;
+                case 2:
+                    b.append(b.mov(b.mem(b.mem(b.lea("p"))), b.mem(b.num(cell))));
+                    break;
+                default:
+                    b.append(b.ones(b.mem(b.num(cell))));
+                    break;
+            }
+        }
+        return b.build();
+    }
+
+    template<typename F>
+    double seconds(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double measure(program &p, ooasm::Backend backend, int boots) {
+        Computer computer(8192, backend);
+        computer.boot(p);
+        return seconds([&] {
+            for (int i = 0; i < boots; ++i)
+                computer.boot(p);
+        });
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int64_t length = argc > 1 ? std::atoll(argv[1]) : 100000;
+    int boots = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    program p = workload(length);
+    double interpreted = measure(p, ooasm::Backend::interpreter, boots);
+    double native = measure(p, ooasm::Backend::jit, boots);
+
+    std::cout << "instructions=" << p.bytecode().code.size() << " boots=" << boots
+              << " interpreter_s=" << interpreted << " jit_s=" << native
+              << " speedup=" << interpreted / native << '\n';
+}
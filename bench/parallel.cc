@@ -0,0 +1,79 @@
+// Compares the interpreter with the parallel backend on a long straight-line program
+// of [lanes] independent chains, cut every 100000 instructions by a barrier writing
+// through a pointer, booted many times on 1, 2, 4 and 8 threads. Prints one line of
+// key=value pairs per run.
+//
+// g++ -Wall -Wextra -O2 -std=c++17 -pthread -I../ooasm_ parallel.cc -o parallel
+// ./parallel 1000000 20 16
+
+#include "computer.h"
+#include "ooasm.h"
+#include "program_builder.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+    // Every lane works on 64 cells of its own, and reads flags it set itself.
+    program workload(int64_t length, int64_t lanes) {
+        ooasm::ProgramBuilder b;
+        b.append(b.data("p", b.num(1)));
+        for (int64_t i = 0; i < length; ++i) {
+            int64_t lane = i % lanes;
+            int64_t cell = 64 + lane * 64 + (i / lanes * 7) % 64;
+            if (i % 100000 == 99999) {
+                b.append(b.inc(b.mem(b.mem(b.lea("p")))));
+                continue;
+            }
+            switch (i / lanes % 4) {
+                case 0:
+                    b.append(b.add(b.mem(b.num(cell)), b.mem(b.num(64 + lane * 64))));
+                    break;
+                case 1:
+                    b.append(b.sub(b.mem(b.num(cell)), b.num(3)));
+                    break;
+                case 2:
+                    b.append(b.mov(b.mem(b.num(cell)), b.mem(b.num(64 + lane * 64 + 1))));
+                    break;
+                default:
+                    b.append(b.ones(b.mem(b.num(cell))));
+                    break;
+            }
+        }
+        return b.build();
+    }
+
+    template<typename F>
+    double seconds(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int64_t length = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    int boots = argc > 2 ? std::atoi(argv[2]) : 20;
+    int64_t lanes = argc > 3 ? std::atoll(argv[3]) : 16;
+
+    program p = workload(length, lanes);
+    auto size = static_cast<ooasm::ComputerMemory::vars_size_t>(64 + lanes * 64);
+
+    auto measure = [&](const char *name, Computer &computer, std::size_t threads) {
+        computer.boot(p);
+        double total = seconds([&] {
+            for (int i = 0; i < boots; ++i)
+                computer.boot(p);
+        });
+        std::cout << "backend=" << name << " threads=" << threads << " instructions=" << p.bytecode().code.size()
+                  << " boot_s=" << total / boots << " boot_ips=" << static_cast<double>(length) * boots / total
+                  << std::endl;
+    };
+
+    Computer interpreter(size, ooasm::Backend::interpreter);
+    measure("interpreter", interpreter, 1);
+    for (std::size_t threads : {1, 2, 4, 8}) {
+        Computer computer(size, ooasm::Backend::parallel, threads);
+        measure("parallel", computer, threads);
+    }
+}
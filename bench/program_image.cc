@@ -0,0 +1,63 @@
+// Compares starting a large program built from its elements with starting it from a
+// program image mapped from a file, with and without checking the image.
+//
+// g++ -Wall -Wextra -O2 -std=c++17 -I../ooasm_ program_image.cc -o program_image
+// ./program_image 2000000
+
+#include "computer.h"
+#include "ooasm.h"
+#include "program_builder.h"
+#include "program_image.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    program workload(int64_t length) {
+        ooasm::ProgramBuilder b;
+        b.append(b.data("p", b.num(1)));
+        for (int64_t i = 0; i < length; ++i) {
+            int64_t cell = 2 + (i * 7) % 4096;
+            if (i % 2 == 0)
+                b.append(b.add(b.mem(b.num(cell)), b.mem(b.lea("p"))));
+            else
+                b.append(b.mov(b.mem(b.mem(b.lea("p"))), b.mem(b.num(cell))));
+        }
+        return b.build();
+    }
+
+    template<typename F>
+    double seconds(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int64_t length = argc > 1 ? std::atoll(argv[1]) : 2000000;
+    const char *path = "program_image_bench.bin";
+
+    Computer computer(8192);
+    double built = seconds([&] {
+        program p = workload(length);
+        computer.boot(p);
+        std::ofstream file(path, std::ios::binary);
+        ooasm::write_program(file, p);
+    });
+
+    double checked = seconds([&] {
+        ooasm::MappedProgram mapped(path);
+        computer.boot(mapped);
+    });
+    double unchecked = seconds([&] {
+        ooasm::MappedProgram mapped(path, false);
+        computer.boot(mapped);
+    });
+    std::remove(path);
+
+    std::cout << "instructions=" << length << " build_and_save_s=" << built << " mapped_checked_s=" << checked
+              << " mapped_unchecked_s=" << unchecked << '\n';
+}
@@ -0,0 +1,64 @@
+// Compares booting a fresh Computer every time, which allocates and zeroes the whole
+// memory, with rebooting one Computer, which zeroes again only the pages written by
+// the previous boot. Sparse programs write a few cells, dense ones touch every page.
+//
+// g++ -Wall -Wextra -O2 -std=c++17 -I../ooasm_ reboot.cc -o reboot
+// ./reboot 16777216 200
+
+#include "computer.h"
+#include "ooasm.h"
+#include "program_builder.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+    program sparse() {
+        ooasm::ProgramBuilder b;
+        for (int64_t i = 0; i < 10; ++i)
+            b.append(b.inc(b.mem(b.num(i * 1000003))));
+        return b.build();
+    }
+
+    program dense(int64_t size) {
+        ooasm::ProgramBuilder b;
+        for (int64_t i = 0; i < size; i += 512)
+            b.append(b.inc(b.mem(b.num(i))));
+        return b.build();
+    }
+
+    template<typename F>
+    double seconds(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void measure(const char *pattern, program &p, int size, int boots) {
+        double fresh = seconds([&] {
+            for (int i = 0; i < boots; ++i) {
+                Computer computer(size);
+                computer.boot(p);
+            }
+        });
+
+        Computer computer(size);
+        double reused = seconds([&] {
+            for (int i = 0; i < boots; ++i)
+                computer.boot(p);
+        });
+
+        std::cout << "pattern=" << pattern << " size=" << size << " boots=" << boots
+                  << " fresh_computer_s=" << fresh << " reboot_s=" << reused << '\n';
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int size = argc > 1 ? std::atoi(argv[1]) : 1 << 24;
+    int boots = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    program p = sparse();
+    measure("sparse", p, size, boots);
+    p = dense(size);
+    measure("dense", p, size, boots);
+}
@@ -0,0 +1,60 @@
+// Compares booting a program with booting it through a result cache, on a long program
+// writing through pointers, which has no summary. Prints one line of key=value pairs
+// per way of booting, the first boot through the cache left out.
+//
+// g++ -Wall -Wextra -O2 -std=c++17 -pthread -I../ooasm_ result_cache.cc -o result_cache
+// ./result_cache 1000000 100
+
+#include "computer.h"
+#include "ooasm.h"
+#include "program_builder.h"
+#include "result_cache.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+    program workload(int64_t length) {
+        ooasm::ProgramBuilder b;
+        b.append(b.data("p", b.num(1)));
+        b.append(b.data("q", b.num(1)));
+        for (int64_t i = 0; i < length; ++i) {
+            int64_t cell = 2 + (i * 7) % 4096;
+            if (i % 2 == 0)
+                b.append(b.add(b.mem(b.num(cell)), b.mem(b.mem(b.lea("p")))));
+            else
+                b.append(b.mov(b.mem(b.mem(b.lea("p"))), b.num(1 + i % 5)));
+        }
+        return b.build();
+    }
+
+    template<typename F>
+    double seconds(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int64_t length = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    int boots = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    program p = workload(length);
+    Computer computer(4098);
+    double plain = seconds([&] {
+        for (int i = 0; i < boots; ++i)
+            computer.boot(p);
+    });
+
+    ooasm::ResultCache cache;
+    computer.boot(p, cache);
+    double cached = seconds([&] {
+        for (int i = 0; i < boots; ++i)
+            computer.boot(p, cache);
+    });
+
+    std::cout << "boot=plain elements=" << length << " boot_s=" << plain / boots << std::endl;
+    std::cout << "boot=cached elements=" << length << " boot_s=" << cached / boots << ' ';
+    cache.report(std::cout);
+}
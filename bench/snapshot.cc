@@ -0,0 +1,74 @@
+// Runs many short tails from a snapshot of a long prefix, on a large memory. Each
+// round restores the snapshot, resumes a tail writing a few cells and takes a snapshot
+// of the result. Prints one line of key=value pairs.
+//
+// g++ -Wall -Wextra -O2 -std=c++17 -pthread -I../ooasm_ snapshot.cc -o snapshot
+// ./snapshot 33554432 4096 10000
+
+#include "computer.h"
+#include "ooasm.h"
+#include "program_builder.h"
+#include "snapshot.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // Writes one cell in each of [pages] pages spread over memory of [size] cells.
+    program prefix(int64_t size, int64_t pages) {
+        ooasm::ProgramBuilder b;
+        b.append(b.data("n", b.num(1)));
+        for (int64_t i = 0; i < pages; ++i)
+            b.append(b.add(b.mem(b.num(1 + i * (size / pages))), b.mem(b.lea("n"))));
+        return b.build();
+    }
+
+    program tail(int64_t size, int64_t round) {
+        ooasm::ProgramBuilder b;
+        b.append(b.data("n", b.num(1)));
+        for (int64_t i = 0; i < 4; ++i)
+            b.append(b.add(b.mem(b.num((round * 7919 + i * 104729) % size)), b.num(round)));
+        return b.build();
+    }
+
+    template<typename F>
+    double seconds(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int64_t size = argc > 1 ? std::atoll(argv[1]) : 33554432;
+    int64_t pages = argc > 2 ? std::atoll(argv[2]) : 4096;
+    int rounds = argc > 3 ? std::atoi(argv[3]) : 10000;
+
+    Computer computer(static_cast<ooasm::ComputerMemory::vars_size_t>(size));
+    program p = prefix(size, pages);
+    computer.boot(p);
+    ooasm::Snapshot start = computer.snapshot();
+
+    std::vector<program> tails;
+    for (int i = 0; i < 64; ++i)
+        tails.push_back(tail(size, i));
+
+    double forks = seconds([&] {
+        for (int i = 0; i < rounds; ++i) {
+            computer.restore(start);
+            computer.resume(tails[i % tails.size()]);
+            ooasm::Snapshot s = computer.snapshot();
+        }
+    });
+
+    double full = seconds([&] {
+        for (int i = 0; i < 10; ++i) {
+            computer.boot(p);
+            ooasm::Snapshot s = computer.snapshot();
+        }
+    });
+
+    std::cout << "cells=" << size << " pages=" << start.pages() << " rounds=" << rounds
+              << " fork_s=" << forks / rounds << " boot_and_snapshot_s=" << full / 10 << std::endl;
+}
@@ -0,0 +1,279 @@
+// Benchmark suite of representative programs at several sizes. Every workload is
+// measured in a child process of its own, so peak RSS is that of the workload alone,
+// and prints one line of key=value pairs (wrapped here):
+//
+//   workload=static elements=100000 instructions=99998 backend=interpreter construct_s=...
+//   first_boot_s=... boot_s=... boot_ips=... dump_s=... dump_cells_per_s=... peak_rss_kb=...
+//
+// [elements] counts the program as written, [instructions] its bytecode after the
+// optimizer. first_boot_s is the time of the first boot, which compiles native code or
+// makes the schedule of the parallel backend, boot_s the time of one of the following
+// boots and boot_ips the declarations and instructions of the bytecode run per second
+// by them. Workloads: declarations - data() only, static - arithmetic on static
+// addresses, lea - accesses through identifiers, indirect - mem(mem(...)) chains up
+// to five deep, flags - arithmetic read by ones() and onez(). All but declarations
+// start from a cell written through a pointer, so that their code is neither folded
+// by the optimizer nor summarized (see summary.h), and every boot runs all of it.
+//
+// g++ -Wall -Wextra -O2 -std=c++17 -I../ooasm_ suite.cc -o suite
+// ./suite                           # sizes 1000 100000 1000000, default backend
+// ./suite jit 10000 1000000 > results.txt
+// ./suite parallel 1000000            # one thread per core
+
+#include "computer.h"
+#include "jit.h"
+#include "ooasm.h"
+#include "program_builder.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+    // Cells above the ones a workload declares, for its static addresses.
+    constexpr int64_t scratch = 4096;
+
+    long peak_rss_kb() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    template<typename F>
+    double seconds(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Discards what is written to it, so dumps are measured without storing them.
+    class NullBuffer : public std::streambuf {
+    protected:
+        std::streamsize xsputn(const char *, std::streamsize n) override {
+            return n;
+        }
+
+        int_type overflow(int_type c) override {
+            return traits_type::not_eof(c);
+        }
+    };
+
+    // Every workload declares cells [0, declared) and uses cells from [declared] on.
+    struct Workload {
+        const char *name;
+        int64_t (*declared)(int64_t elements);
+        void (*generate)(ooasm::ProgramBuilder &b, int64_t elements);
+    };
+
+    // Elements appended by seed().
+    constexpr int64_t seeding = 3;
+
+    // Writes a declared value through a declared pointer. The optimizer never assumes
+    // declared values and forgets all it knows at a write through a pointer, and code
+    // with one has no summary.
+    void seed(ooasm::ProgramBuilder &b) {
+        b.append(b.data("seed", b.num(3)));
+        b.append(b.data("p", b.num(100)));
+        b.append(b.mov(b.mem(b.mem(b.lea("p"))), b.mem(b.lea("seed"))));
+    }
+
+    void declarations(ooasm::ProgramBuilder &b, int64_t elements) {
+        for (int64_t i = 0; i < elements; ++i)
+            b.append(b.data(("v" + std::to_string(i)).c_str(), b.num(i)));
+    }
+
+    void static_arithmetic(ooasm::ProgramBuilder &b, int64_t elements) {
+        seed(b);
+        for (int64_t i = seeding; i < elements; ++i) {
+            int64_t cell = (i * 7) % scratch;
+            switch (i % 3) {
+                case 0:
+                    b.append(b.add(b.mem(b.num(cell)), b.mem(b.num((cell + 1) % scratch))));
+                    break;
+                case 1:
+                    b.append(b.sub(b.mem(b.num(cell)), b.num(3)));
+                    break;
+                default:
+                    b.append(b.mov(b.mem(b.num(cell)), b.mem(b.num((cell + 5) % scratch))));
+                    break;
+            }
+        }
+    }
+
+    const char *const names[] = {"a", "b", "c", "d", "e", "f", "g", "h"};
+
+    void through_lea(ooasm::ProgramBuilder &b, int64_t elements) {
+        for (const char *name : names)
+            b.append(b.data(name, b.num(1)));
+        seed(b);
+        for (int64_t i = 8 + seeding; i < elements; ++i) {
+            const char *name = names[i % 8];
+            const char *other = names[(i + 3) % 8];
+            switch (i % 3) {
+                case 0:
+                    b.append(b.add(b.mem(b.lea(name)), b.mem(b.lea(other))));
+                    break;
+                case 1:
+                    b.append(b.mov(b.mem(b.num(8 + i % 64)), b.lea(name)));
+                    break;
+                default:
+                    b.append(b.sub(b.mem(b.lea(other)), b.mem(b.num(8 + i % 64))));
+                    break;
+            }
+        }
+    }
+
+    // Cells 0 to 3 form a chain of pointers ending at cell 16, which is never written
+    // through a static address, so every chain stays intact.
+    std::shared_ptr<ooasm::Mem> chain(ooasm::ProgramBuilder &b, int64_t from, int depth) {
+        std::shared_ptr<ooasm::Mem> m = b.mem(b.num(from));
+        for (int i = 1; i < depth; ++i)
+            m = b.mem(m);
+        return m;
+    }
+
+    void indirect(ooasm::ProgramBuilder &b, int64_t elements) {
+        b.append(b.data("a", b.num(1)));
+        b.append(b.data("b", b.num(2)));
+        b.append(b.data("c", b.num(3)));
+        b.append(b.data("d", b.num(16)));
+        for (int64_t i = 4; i < elements; ++i) {
+            switch (i % 3) {
+                case 0:
+                    b.append(b.add(chain(b, 0, 5), b.num(i % 11)));
+                    break;
+                case 1:
+                    b.append(b.mov(b.mem(b.num(17 + i % 64)), chain(b, 1, 4)));
+                    break;
+                default:
+                    b.append(b.sub(chain(b, 2, 3), b.mem(b.num(17 + i % 64))));
+                    break;
+            }
+        }
+    }
+
+    void flags(ooasm::ProgramBuilder &b, int64_t elements) {
+        seed(b);
+        for (int64_t i = seeding; i < elements; ++i) {
+            int64_t cell = i % scratch;
+            switch (i % 4) {
+                case 0:
+                    b.append(b.sub(b.mem(b.num(cell)), b.num(i % 5)));
+                    break;
+                case 1:
+                    b.append(b.ones(b.mem(b.num((cell + 9) % scratch))));
+                    break;
+                case 2:
+                    b.append(b.add(b.mem(b.num(cell)), b.num(1)));
+                    break;
+                default:
+                    b.append(b.onez(b.mem(b.num((cell + 17) % scratch))));
+                    break;
+            }
+        }
+    }
+
+    int64_t all(int64_t elements) {
+        return elements;
+    }
+
+    int64_t few(int64_t) {
+        return 64;
+    }
+
+    const Workload workloads[] = {
+            {"declarations", all, declarations},
+            {"static", few, static_arithmetic},
+            {"lea", few, through_lea},
+            {"indirect", few, indirect},
+            {"flags", few, flags}
+    };
+
+    const char *const backend_names[] = {"interpreter", "jit", "parallel"};
+
+    void measure(const Workload &w, int64_t elements, ooasm::Backend backend) {
+        auto start = std::chrono::steady_clock::now();
+        ooasm::ProgramBuilder b;
+        b.reserve(static_cast<std::size_t>(elements));
+        w.generate(b, elements);
+        program p = b.build();
+        double construct = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        auto size = static_cast<ooasm::ComputerMemory::vars_size_t>(w.declared(elements) + scratch);
+        Computer computer(size, backend);
+        double first_boot = seconds([&] { computer.boot(p); });
+
+        // Boots until a quarter of a second has passed, at least three times.
+        int boots = 0;
+        double boot = 0;
+        while (boots < 3 || boot < 0.25) {
+            boot += seconds([&] { computer.boot(p); });
+            ++boots;
+        }
+
+        NullBuffer sink;
+        std::ostream os(&sink);
+        int dumps = 0;
+        double dump = 0;
+        while (dumps < 3 || dump < 0.25) {
+            dump += seconds([&] { computer.memory_dump(os); });
+            ++dumps;
+        }
+
+        std::size_t executed = p.bytecode().declarations.size() + p.bytecode().code.size();
+        std::cout << "workload=" << w.name << " elements=" << elements
+                  << " instructions=" << p.bytecode().code.size()
+                  << " backend=" << backend_names[static_cast<int>(backend)]
+                  << " construct_s=" << construct
+                  << " first_boot_s=" << first_boot
+                  << " boot_s=" << boot / boots
+                  << " boot_ips=" << static_cast<double>(executed) * boots / boot
+                  << " dump_s=" << dump / dumps
+                  << " dump_cells_per_s=" << static_cast<double>(size) * dumps / dump
+                  << " peak_rss_kb=" << peak_rss_kb() << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    ooasm::Backend backend = ooasm::default_backend;
+    std::vector<int64_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "jit") == 0)
+            backend = ooasm::Backend::jit;
+        else if (std::strcmp(argv[i], "interpreter") == 0)
+            backend = ooasm::Backend::interpreter;
+        else if (std::strcmp(argv[i], "parallel") == 0)
+            backend = ooasm::Backend::parallel;
+        else
+            sizes.push_back(std::atoll(argv[i]));
+    }
+    if (sizes.empty())
+        sizes = {1000, 100000, 1000000};
+
+    int failures = 0;
+    for (const auto &w : workloads) {
+        for (int64_t elements : sizes) {
+            std::cout.flush();
+            pid_t child = fork();
+            if (child == 0) {
+                measure(w, elements, backend);
+                std::_Exit(0);
+            }
+
+            int status = 0;
+            waitpid(child, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                std::cerr << "workload=" << w.name << " elements=" << elements << " failed\n";
+                ++failures;
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
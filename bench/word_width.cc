@@ -0,0 +1,95 @@
+// Compares words of 64, 32 and 16 bits on two workloads bound by memory: a batch over
+// many lanes, whose rows are loops over contiguous words, and boots of a computer
+// sweeping a large memory through pointers. Prints one line of key=value pairs per
+// workload and width, with the bytes of memory it goes through. Kernels over lanes are
+// vectorized at -O3, where narrower words fit more lanes in every vector.
+//
+// g++ -Wall -Wextra -O3 -std=c++17 -pthread -I../ooasm_ word_width.cc -o word_width
+// ./word_width 262144 16777216 20
+
+#include "batch.h"
+#include "computer.h"
+#include "ooasm.h"
+#include "program_builder.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // Arithmetic and flags over 16 cells, the same in every lane.
+    program lanes_workload() {
+        ooasm::ProgramBuilder b;
+        b.append(b.data("a", b.num(3)));
+        b.append(b.data("b", b.num(-5)));
+        for (int i = 0; i < 64; ++i) {
+            int64_t cell = 2 + i % 14;
+            b.append(b.add(b.mem(b.num(cell)), b.mem(b.lea(i % 2 ? "a" : "b"))));
+            if (i % 8 == 7)
+                b.append(b.ones(b.mem(b.num(2 + (i + 3) % 14))));
+        }
+        return b.build();
+    }
+
+    // Writes one cell in every 64 of [size], walking a pointer through memory.
+    program sweep_workload(int64_t size) {
+        ooasm::ProgramBuilder b;
+        b.append(b.data("p", b.num(1)));
+        b.append(b.data("n", b.num(1)));
+        for (int64_t i = 0; i < size / 64; ++i) {
+            b.append(b.add(b.mem(b.mem(b.lea("p"))), b.mem(b.lea("n"))));
+            b.append(b.add(b.mem(b.lea("p")), b.num(64)));
+        }
+        return b.build();
+    }
+
+    template<typename F>
+    double seconds(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    template<typename Word>
+    void lanes(const program &p, std::size_t count, int boots) {
+        ooasm::BasicBatchComputer<Word> computer(16, count);
+        std::vector<std::vector<int64_t>> initial(count);
+        computer.boot(p, initial);
+        double s = seconds([&] {
+            for (int i = 0; i < boots; ++i)
+                computer.boot(p, initial);
+        });
+        std::cout << "workload=lanes word_bits=" << sizeof(Word) * 8 << " lanes=" << count
+                  << " bytes=" << 16 * count * sizeof(Word) << " boot_s=" << s / boots << std::endl;
+    }
+
+    template<typename Word>
+    void sweep(program &p, int64_t size, int boots) {
+        BasicComputer<Word> computer(static_cast<ooasm::ComputerMemory::vars_size_t>(size),
+                                     ooasm::Backend::interpreter);
+        computer.boot(p);
+        double s = seconds([&] {
+            for (int i = 0; i < boots; ++i)
+                computer.boot(p);
+        });
+        std::cout << "workload=sweep word_bits=" << sizeof(Word) * 8 << " cells=" << size
+                  << " bytes=" << size * static_cast<int64_t>(sizeof(Word)) << " boot_s=" << s / boots << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 262144;
+    int64_t size = argc > 2 ? std::atoll(argv[2]) : 16777216;
+    int boots = argc > 3 ? std::atoi(argv[3]) : 20;
+
+    program l = lanes_workload();
+    lanes<int64_t>(l, count, boots);
+    lanes<int32_t>(l, count, boots);
+    lanes<int16_t>(l, count, boots);
+
+    // Pointers into 2^24 cells do not fit in 16 bits.
+    program s = sweep_workload(size);
+    sweep<int64_t>(s, size, boots);
+    sweep<int32_t>(s, size, boots);
+}
@@ -0,0 +1,91 @@
+#ifndef OOASM_ARENA_H
+#define OOASM_ARENA_H
+
+// Bump allocator for elements of a program.
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ooasm {
+    // Hands out memory from large chunks one after another and releases it all at once,
+    // when the arena is destroyed. Deallocation of a single object is a no-op.
+    class Arena {
+    private:
+        static constexpr std::size_t first_chunk_size = 64 * 1024;
+        static constexpr std::size_t max_chunk_size = 16 * 1024 * 1024;
+
+        std::vector<std::unique_ptr<std::byte[]>> chunks;
+        std::byte *next = nullptr;
+        std::size_t left = 0;
+        std::size_t chunk_size = first_chunk_size;
+
+        void grow(std::size_t bytes) {
+            std::size_t size = std::max(chunk_size, bytes + alignof(std::max_align_t));
+            chunks.push_back(std::make_unique<std::byte[]>(size));
+            next = chunks.back().get();
+            left = size;
+            chunk_size = std::min(chunk_size * 2, max_chunk_size);
+        }
+
+    public:
+        Arena() = default;
+
+        Arena(const Arena &) = delete;
+
+        Arena &operator=(const Arena &) = delete;
+
+        void *allocate(std::size_t bytes, std::size_t alignment) {
+            void *p = next;
+            if (std::align(alignment, bytes, p, left) == nullptr) {
+                grow(bytes);
+                p = next;
+                std::align(alignment, bytes, p, left);
+            }
+
+            next = static_cast<std::byte *>(p) + bytes;
+            left -= bytes;
+            return p;
+        }
+    };
+
+    // Standard allocator drawing from an arena, to be used with std::allocate_shared.
+    // Every copy shares ownership of the arena, so the control block of a shared_ptr,
+    // which keeps one, holds the arena until the object and the block are released.
+    template<typename T>
+    class ArenaAllocator {
+    private:
+        template<typename U>
+        friend class ArenaAllocator;
+
+        std::shared_ptr<Arena> arena;
+
+    public:
+        using value_type = T;
+
+        explicit ArenaAllocator(std::shared_ptr<Arena> _arena) noexcept : arena(std::move(_arena)) {}
+
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena(other.arena) {}
+
+        T *allocate(std::size_t n) {
+            return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate([[maybe_unused]] T *p, [[maybe_unused]] std::size_t n) noexcept {}
+
+        template<typename U>
+        bool operator==(const ArenaAllocator<U> &other) const noexcept {
+            return arena == other.arena;
+        }
+
+        template<typename U>
+        bool operator!=(const ArenaAllocator<U> &other) const noexcept {
+            return arena != other.arena;
+        }
+    };
+}
+
+#endif //OOASM_ARENA_H
@@ -0,0 +1,37 @@
+#ifndef OOASM_BACKEND_CACHE_H
+#define OOASM_BACKEND_CACHE_H
+
+// Data the backends derive from the code of a program, kept with the program.
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+namespace ooasm {
+    // What a backend may derive from the code of a program: native code (see jit.h),
+    // a schedule for the parallel backend (see parallel.h) and a summary (see summary.h).
+    enum class backend_data : std::size_t {
+        native, schedule, summary, count
+    };
+
+    // Holds what the backends derived from the code of a program, each made on first use
+    // and shared by copies of the program and by all threads booting it. Types held are
+    // only named by the backends asking for them, so programs do not depend on backends:
+    // a type [T] is default-constructible and tells its kind in T::slot.
+    class BackendCache {
+    private:
+        static constexpr auto kinds = static_cast<std::size_t>(backend_data::count);
+
+        std::once_flag made[kinds];
+        std::shared_ptr<void> data[kinds];
+
+    public:
+        template<typename T>
+        T &get() {
+            constexpr auto i = static_cast<std::size_t>(T::slot);
+            std::call_once(made[i], [this] { data[i] = std::make_shared<T>(); });
+            return *static_cast<T *>(data[i].get());
+        }
+    };
+}
+
+#endif //OOASM_BACKEND_CACHE_H
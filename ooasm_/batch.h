@@ -0,0 +1,330 @@
+#ifndef OOASM_BATCH_H
+#define OOASM_BATCH_H
+
+// Execution of one program over many memory images at once.
+#include "bytecode.h"
+#include "computer_memory.h"
+#include "linker.h"
+#include "ooasm.h"
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Kernels over lanes are compiled for AVX-512, AVX2 and plain x86-64 and the best
+// version for the running CPU is picked when the program starts.
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define OOASM_LANES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define OOASM_LANES
+#endif
+
+namespace ooasm {
+    // Loops over all lanes of one memory row. [active] is either null, when every lane
+    // takes part, or holds 1 for lanes that take part and 0 for the others. Narrower
+    // words fit more lanes in every vector register.
+    namespace lanes {
+        template<typename word_t>
+        OOASM_LANES inline void broadcast(word_t *d, word_t value, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i)
+                d[i] = value;
+        }
+
+        template<typename word_t>
+        OOASM_LANES inline void mov(word_t *d, const word_t *s, const word_t *active, std::size_t n) {
+            if (active == nullptr) {
+                for (std::size_t i = 0; i < n; ++i)
+                    d[i] = s[i];
+            } else {
+                for (std::size_t i = 0; i < n; ++i)
+                    d[i] = active[i] ? s[i] : d[i];
+            }
+        }
+
+        // Adds (or subtracts, with [negate]) [s] to [d] and sets flags of every lane.
+        template<typename word_t>
+        OOASM_LANES inline void add(word_t *d, const word_t *s, word_t *zf, word_t *sf,
+                                    const word_t *active, std::size_t n, bool negate) {
+            using uword_t = std::make_unsigned_t<word_t>;
+            auto *ud = reinterpret_cast<uword_t *>(d);
+            const auto *us = reinterpret_cast<const uword_t *>(s);
+            auto sign = static_cast<uword_t>(negate ? ~uword_t(0) : 0);
+
+            if (active == nullptr) {
+                for (std::size_t i = 0; i < n; ++i) {
+                    ud[i] = static_cast<uword_t>(ud[i] + static_cast<uword_t>(static_cast<uword_t>(us[i] ^ sign) - sign));
+                    zf[i] = d[i] == 0;
+                    sf[i] = d[i] < 0;
+                }
+            } else {
+                for (std::size_t i = 0; i < n; ++i) {
+                    auto r = static_cast<uword_t>(ud[i] + static_cast<uword_t>(static_cast<uword_t>(us[i] ^ sign) - sign));
+                    auto v = static_cast<word_t>(r);
+                    d[i] = active[i] ? v : d[i];
+                    zf[i] = active[i] ? v == 0 : zf[i];
+                    sf[i] = active[i] ? v < 0 : sf[i];
+                }
+            }
+        }
+
+        // Sets [d] to one in lanes where [flag] is set, or in every lane when [flag] is null.
+        template<typename word_t>
+        OOASM_LANES inline void one(word_t *d, const word_t *flag, const word_t *active, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                bool set = (active == nullptr || active[i]) && (flag == nullptr || flag[i]);
+                d[i] = set ? 1 : d[i];
+            }
+        }
+    }
+
+    // Runs one program over [lanes] memory images of [size] cells that differ only in
+    // the initial values of variables. Memory is stored as structure of arrays, one row
+    // of lanes per cell, so instructions on static addresses become loops over
+    // contiguous rows. Every lane keeps its own flags; a lane that fails stops there,
+    // keeping its memory as it was, and the others go on.
+    //
+    // Memory holds words of type [Word], with the semantics of BasicComputerMemory.
+    template<typename Word = memory_word_t>
+    class BasicBatchComputer {
+        static_assert(std::is_integral_v<Word> && std::is_signed_v<Word> && sizeof(Word) >= 2 && sizeof(Word) <= 8,
+                      "Words are signed integers of 16 to 64 bits");
+
+    private:
+        using size_type = ComputerMemory::vars_size_t;
+
+        size_type size;
+        std::size_t lanes;
+        std::vector<Word> mem;
+        std::vector<Word> ZF, SF;
+        std::vector<Word> active;
+        std::vector<std::exception_ptr> errors;
+        std::size_t failures = 0;
+
+        // Scratch rows for operands at dynamic addresses.
+        std::vector<Word> src_row, dst_row;
+        std::vector<size_type> src_address, dst_address;
+
+        Word *row(size_type cell) {
+            return mem.data() + cell * lanes;
+        }
+
+        void fail(std::size_t lane, const std::exception_ptr &error) {
+            if (!active[lane])
+                return;
+
+            active[lane] = 0;
+            errors[lane] = error;
+            ++failures;
+        }
+
+        void fail_all(const std::exception_ptr &error) {
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+                fail(lane, error);
+        }
+
+        const Word *mask() const {
+            return failures == 0 ? nullptr : active.data();
+        }
+
+        // Tells whether the lane takes part in an instruction that only acts where [flag]
+        // is set, or in any instruction when [flag] is null.
+        bool takes_part(std::size_t lane, const Word *flag) const {
+            return active[lane] && (flag == nullptr || flag[lane]);
+        }
+
+        // Follows the references of an indirect operand in every lane taking part. Lanes
+        // whose address goes out of bounds fail; lanes that fail or do not take part get
+        // address zero.
+        void follow(memory_word_t operand, uint32_t depth, std::vector<size_type> &address, const Word *flag) {
+            static const auto out_of_bounds = std::make_exception_ptr(std::invalid_argument("Out of bounds"));
+
+            address.assign(lanes, static_cast<size_type>(operand));
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                for (uint32_t i = 1; i < depth && takes_part(lane, flag); ++i) {
+                    if (address[lane] >= size)
+                        fail(lane, out_of_bounds);
+                    else
+                        address[lane] = static_cast<size_type>(mem[address[lane] * lanes + lane]);
+                }
+
+                if (takes_part(lane, flag) && address[lane] >= size)
+                    fail(lane, out_of_bounds);
+                if (!takes_part(lane, flag))
+                    address[lane] = 0;
+            }
+        }
+
+        // Returns the row holding values of an r-value operand in every lane.
+        const Word *value(mode m, memory_word_t operand, uint32_t depth) {
+            if (m == mode::imm) {
+                lanes::broadcast(src_row.data(), wrap<Word>(operand), lanes);
+                return src_row.data();
+            }
+            if (m == mode::cell)
+                return row(static_cast<size_type>(operand));
+
+            follow(operand, depth, src_address, nullptr);
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+                src_row[lane] = mem[src_address[lane] * lanes + lane];
+
+            return src_row.data();
+        }
+
+        // Returns the row of cells an l-value operand refers to in every lane taking part.
+        // For dynamic addresses it is a scratch row, written back by store().
+        Word *reference(mode m, memory_word_t operand, uint32_t depth, const Word *flag) {
+            if (m == mode::cell)
+                return row(static_cast<size_type>(operand));
+
+            follow(operand, depth, dst_address, flag);
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+                dst_row[lane] = mem[dst_address[lane] * lanes + lane];
+
+            return dst_row.data();
+        }
+
+        void store(mode m, const Word *flag) {
+            if (m == mode::cell)
+                return;
+
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                if (takes_part(lane, flag))
+                    mem[dst_address[lane] * lanes + lane] = dst_row[lane];
+            }
+        }
+
+        // Checks static addresses of an instruction, which are the same in every lane.
+        bool in_bounds(const Instruction &ins) const {
+            auto valid = [this](mode m, memory_word_t operand) {
+                return m == mode::imm || static_cast<size_type>(operand) < size;
+            };
+
+            return valid(ins.dst_mode, ins.dst) && valid(ins.src_mode, ins.src);
+        }
+
+        void declare(const Bytecode &bc, const std::vector<std::vector<memory_word_t>> &initial) {
+            std::size_t count = bc.declarations.size();
+            for (std::size_t k = 0; k < count && k < size; ++k) {
+                Word *cells = row(k);
+                for (std::size_t lane = 0; lane < lanes; ++lane)
+                    cells[lane] = wrap<Word>(initial[lane].empty() ? bc.declarations[k].value : initial[lane][k]);
+            }
+
+            if (count > size)
+                fail_all(std::make_exception_ptr(std::invalid_argument("Too many variables")));
+        }
+
+        void execute(const Bytecode &bc) {
+            static const auto out_of_bounds = std::make_exception_ptr(std::invalid_argument("Out of bounds"));
+
+            std::size_t bound = Linker::bound(bc, size);
+            for (std::size_t i = 0; i < bc.code.size(); ++i) {
+                const Instruction &ins = bc.code[i];
+                if (failures == lanes)
+                    return;
+
+                // Ones and onez do nothing in lanes whose flag is clear, not even look at
+                // their operand.
+                const Word *flag = nullptr;
+                if (ins.op == opcode::ones)
+                    flag = SF.data();
+                else if (ins.op == opcode::onez)
+                    flag = ZF.data();
+
+                if (i >= bound && !in_bounds(ins)) {
+                    if (flag == nullptr) {
+                        fail_all(out_of_bounds);
+                        return;
+                    }
+                    for (std::size_t lane = 0; lane < lanes; ++lane) {
+                        if (flag[lane])
+                            fail(lane, out_of_bounds);
+                    }
+                    continue;
+                }
+
+                const Word *s = nullptr;
+                if (ins.op == opcode::mov || ins.op == opcode::add || ins.op == opcode::sub)
+                    s = value(ins.src_mode, ins.src, ins.src_depth);
+                Word *d = reference(ins.dst_mode, ins.dst, ins.dst_depth, flag);
+
+                switch (ins.op) {
+                    case opcode::mov:
+                        lanes::mov(d, s, mask(), lanes);
+                        break;
+                    case opcode::add:
+                    case opcode::sub:
+                        lanes::add(d, s, ZF.data(), SF.data(), mask(), lanes, ins.op == opcode::sub);
+                        break;
+                    case opcode::one:
+                        lanes::one<Word>(d, nullptr, mask(), lanes);
+                        break;
+                    case opcode::ones:
+                    case opcode::onez:
+                        lanes::one(d, flag, mask(), lanes);
+                        break;
+                }
+
+                store(ins.dst_mode, flag);
+            }
+        }
+
+    public:
+        BasicBatchComputer(ComputerMemory::vars_size_t _size, std::size_t _lanes) : size(_size), lanes(_lanes) {}
+
+        // Boots the program in every lane. [initial] holds, for every lane, values of the
+        // program's declarations in order of appearance, or nothing to keep the values
+        // given by the program.
+        void boot(const program &p, const std::vector<std::vector<memory_word_t>> &initial) {
+            const Bytecode &bc = p.bytecode(sizeof(Word) * 8);
+            if (initial.size() != lanes)
+                throw std::invalid_argument("Initial values should be given for every lane");
+            for (const auto &values : initial) {
+                if (!values.empty() && values.size() != bc.declarations.size())
+                    throw std::invalid_argument("Initial values should be given for every declaration");
+            }
+
+            mem.assign(size * lanes, 0);
+            ZF.assign(lanes, 0);
+            SF.assign(lanes, 0);
+            active.assign(lanes, 1);
+            errors.assign(lanes, nullptr);
+            failures = 0;
+            src_row.resize(lanes);
+            dst_row.resize(lanes);
+
+            declare(bc, initial);
+            if (bc.unresolved)
+                fail_all(std::make_exception_ptr(std::invalid_argument("Variable not found")));
+            execute(bc);
+        }
+
+        // Tells whether the lane stopped with an error.
+        [[nodiscard]] bool failed(std::size_t lane) const {
+            return errors.at(lane) != nullptr;
+        }
+
+        // Returns the error the lane stopped with, or null.
+        [[nodiscard]] std::exception_ptr error(std::size_t lane) const {
+            return errors.at(lane);
+        }
+
+        // Dumps memory of one lane in the format of Computer::memory_dump.
+        void memory_dump(std::size_t lane, std::ostream &os) const {
+            if (lane >= lanes)
+                throw std::out_of_range("No such lane");
+
+            for (size_type cell = 0; cell < size && !mem.empty(); ++cell)
+                os << mem[cell * lanes + lane] << ' ';
+        }
+    };
+
+    using BatchComputer = BasicBatchComputer<>;
+}
+
+#undef OOASM_LANES
+
+#endif //OOASM_BATCH_H
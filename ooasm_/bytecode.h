@@ -0,0 +1,245 @@
+#ifndef OOASM_BYTECODE_H
+#define OOASM_BYTECODE_H
+
+// Flat, pre-decoded form of an OOAsm program.
+#include "computer_memory.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ooasm {
+    // Operation of a single instruction. Inc and Dec are lowered to Add and Sub of one,
+    // declarations are kept apart from the instructions.
+    enum class opcode : uint8_t {
+        mov, add, sub, one, ones, onez
+    };
+
+    // Addressing mode of an operand, decoded once when the program is loaded:
+    // imm          - numeric literal, num(v),
+    // sym          - effective address of an identifier, lea(id),
+    // cell         - memory cell at a literal address, mem(num(v)),
+    // sym_cell     - memory cell at the address of an identifier, mem(lea(id)),
+    // indirect     - mem(...(mem(num(v)))) nested [depth] times,
+    // sym_indirect - mem(...(mem(lea(id)))) nested [depth] times.
+    enum class mode : uint8_t {
+        imm, sym, cell, sym_cell, indirect, sym_indirect
+    };
+
+    // Operand as seen while lowering the program. [value] is either a literal
+    // or an index into the table of identifiers, [depth] counts enclosing mem().
+    struct Operand {
+        memory_word_t value = 0;
+        uint32_t depth = 0;
+        bool symbol = false;
+
+        [[nodiscard]] mode decode() const noexcept {
+            if (depth == 0)
+                return symbol ? mode::sym : mode::imm;
+            if (depth == 1)
+                return symbol ? mode::sym_cell : mode::cell;
+            return symbol ? mode::sym_indirect : mode::indirect;
+        }
+    };
+
+    // Single instruction of the bytecode. Operands are stored inline so the whole
+    // program sits in one contiguous buffer. [sets_flags] tells whether an arithmetic
+    // instruction has to record its result for the flags.
+    struct Instruction {
+        memory_word_t dst = 0;
+        memory_word_t src = 0;
+        uint32_t dst_depth = 0;
+        uint32_t src_depth = 0;
+        opcode op = opcode::mov;
+        mode dst_mode = mode::cell;
+        mode src_mode = mode::imm;
+        bool sets_flags = true;
+    };
+
+    // Declaration of a variable, [symbol] indexes the table of identifiers.
+    struct Declaration {
+        uint32_t symbol;
+        memory_word_t value;
+    };
+
+    // Program lowered to bytecode: identifiers, declarations in order of appearance
+    // and the remaining instructions in order of appearance. Once linked, the code
+    // refers to addresses only and [unresolved] tells whether some identifier
+    // used by the code was never declared. Once bound, [reach] holds for every
+    // instruction the size of memory needed by static addresses of the code up to it.
+    struct Bytecode {
+        std::vector<identifier_t> symbols;
+        std::vector<Declaration> declarations;
+        std::vector<Instruction> code;
+        std::vector<uint64_t> reach;
+        bool unresolved = false;
+    };
+
+    // Read-only view of a contiguous array.
+    template<typename T>
+    class Span {
+    private:
+        const T *first = nullptr;
+        std::size_t count = 0;
+
+    public:
+        Span() = default;
+
+        Span(const T *_first, std::size_t _count) : first(_first), count(_count) {}
+
+        // Views a whole vector, implicitly so a vector can be passed where a span is expected.
+        Span(const std::vector<T> &v) : first(v.data()), count(v.size()) {}
+
+        const T &operator[](std::size_t i) const noexcept {
+            return first[i];
+        }
+
+        [[nodiscard]] const T *begin() const noexcept {
+            return first;
+        }
+
+        [[nodiscard]] const T *end() const noexcept {
+            return first + count;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return count;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return count == 0;
+        }
+
+        [[nodiscard]] const T &back() const noexcept {
+            return first[count - 1];
+        }
+    };
+
+    // What running linked code needs of its bytecode, wherever the bytecode is stored:
+    // in a Bytecode, or in a program image mapped from a file (see program_image.h).
+    struct BytecodeView {
+        Span<Declaration> declarations;
+        Span<Instruction> code;
+        Span<uint64_t> reach;
+        bool unresolved = false;
+
+        BytecodeView() = default;
+
+        // Views a Bytecode, implicitly so one can be passed where a view is expected.
+        BytecodeView(const Bytecode &bc)
+                : declarations(bc.declarations), code(bc.code), reach(bc.reach), unresolved(bc.unresolved) {}
+    };
+
+    // Content fingerprint of code, made of two independent 64-bit hashes of everything
+    // booting it depends on: values of declarations and instructions with their operands.
+    // Names of identifiers are left out, they are gone once the code is linked.
+    struct Fingerprint {
+        uint64_t high = 0;
+        uint64_t low = 0;
+
+        bool operator==(const Fingerprint &other) const noexcept {
+            return high == other.high && low == other.low;
+        }
+
+        bool operator!=(const Fingerprint &other) const noexcept {
+            return !(*this == other);
+        }
+    };
+
+    inline Fingerprint fingerprint(const BytecodeView &bc) {
+        // Final mix of splitmix64.
+        auto mix = [](uint64_t x) {
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+            return x ^ (x >> 31);
+        };
+
+        uint64_t a = 0x6a09e667f3bcc908, b = 0xbb67ae8584caa73b;
+        auto word = [&](uint64_t w) {
+            a = (a ^ w) * 0x100000001b3;
+            a ^= a >> 32;
+            b = mix(b + w);
+        };
+
+        word(bc.declarations.size());
+        for (const auto &d : bc.declarations)
+            word(static_cast<uint64_t>(d.value));
+        word(bc.code.size());
+        for (const auto &ins : bc.code) {
+            word(static_cast<uint64_t>(ins.dst));
+            word(static_cast<uint64_t>(ins.src));
+            word(uint64_t(ins.dst_depth) << 32 | ins.src_depth);
+            word(uint64_t(ins.op) | uint64_t(ins.dst_mode) << 8 | uint64_t(ins.src_mode) << 16 |
+                 uint64_t(ins.sets_flags) << 24);
+        }
+        word(bc.unresolved);
+        return {mix(a), b};
+    }
+
+    // Builds the bytecode of a program. Elements of the language lower themselves
+    // through it, so the program's shape is never inspected from the outside.
+    class Assembler {
+    private:
+        Bytecode bc;
+        std::unordered_map<identifier_t, uint32_t> interned;
+
+        uint32_t intern(const identifier_t &id) {
+            auto it = interned.find(id);
+            if (it != interned.end())
+                return it->second;
+
+            auto index = static_cast<uint32_t>(bc.symbols.size());
+            bc.symbols.push_back(id);
+            interned.emplace(id, index);
+            return index;
+        }
+
+    public:
+        static Operand literal(memory_word_t value) noexcept {
+            return {value, 0, false};
+        }
+
+        Operand symbol(const identifier_t &id) {
+            return {intern(id), 0, true};
+        }
+
+        static Operand dereference(Operand address) noexcept {
+            ++address.depth;
+            return address;
+        }
+
+        void declare(const identifier_t &id, memory_word_t value) {
+            bc.declarations.push_back({intern(id), value});
+        }
+
+        void emit(opcode op, const Operand &dst, const Operand &src = literal(0)) {
+            Instruction ins;
+            ins.op = op;
+            ins.dst = dst.value;
+            ins.dst_depth = dst.depth;
+            ins.dst_mode = dst.decode();
+            ins.src = src.value;
+            ins.src_depth = src.depth;
+            ins.src_mode = src.decode();
+            bc.code.push_back(ins);
+        }
+
+        // Number of declarations and of instructions so far.
+        [[nodiscard]] std::size_t declared() const noexcept {
+            return bc.declarations.size();
+        }
+
+        [[nodiscard]] std::size_t emitted() const noexcept {
+            return bc.code.size();
+        }
+
+        Bytecode finish() {
+            interned.clear();
+            return std::move(bc);
+        }
+    };
+}
+
+#endif //OOASM_BYTECODE_H
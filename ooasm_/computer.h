@@ -1,46 +1,300 @@
-#ifndef OOASM_COMPUTER_H
-#define OOASM_COMPUTER_H
-
-#include <ostream>
-#include "ooasm.h"
-#include "computer_memory.h"
-
-class Computer {
-private:
-    ooasm::ComputerMemory cm;
-
-    // Executes all declarations of the program.
-    void declare_vars(program &p) {
-        for (const auto &command : p) {
-            if (command->is_definition())
-                command->execute(cm);
-        }
-    }
-
-    // Executes all functions that aren't declarations.
-    void execute_functions(program &p) {
-        for (const auto &command : p) {
-            if (!command->is_definition())
-                command->execute(cm);
-        }
-    }
-
-public:
-    explicit Computer(const int &size) {
-        cm.size = size;
-    }
-
-    void boot(program &p) {
-        cm.setup();
-        declare_vars(p);
-        execute_functions(p);
-    }
-
-    void memory_dump(std::ostream &os) const {
-        for (auto a : cm.mem) {
-            os << a << ' ';
-        }
-    }
-};
-
+#ifndef OOASM_COMPUTER_H
+#define OOASM_COMPUTER_H
+
+#include <ostream>
+#include "ooasm.h"
+#include "computer_memory.h"
+#include "editable.h"
+#include "interpreter.h"
+#include "backend_cache.h"
+#include "jit.h"
+#include "memory_image.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "program_image.h"
+#include "result_cache.h"
+#include "snapshot.h"
+#include "stream.h"
+#include "summary.h"
+#include "tracer.h"
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+// Computer over memory of words of type [Word], see BasicComputerMemory. Computer, over
+// 64-bit words, boots programs on any backend. Narrower words take half or a quarter
+// of the memory and of the bandwidth; computers over them interpret programs whatever
+// their backend. Result caches, edited and streamed programs and snapshots need 64-bit
+// words.
+template<typename Word = ooasm::memory_word_t>
+class BasicComputer {
+private:
+    static constexpr bool wide = std::is_same_v<Word, ooasm::memory_word_t>;
+
+    ooasm::BasicComputerMemory<Word> cm;
+    ooasm::Backend backend;
+    std::unique_ptr<ooasm::ParallelExecutor> parallel;
+
+    // Cells as of the last delta dump, kept only for cells written since tracking began.
+    std::unordered_map<ooasm::ComputerMemory::vars_size_t, ooasm::memory_word_t> published;
+    ooasm::ComputerMemory::vars_size_t published_size = 0;
+
+    // Executes all declarations of the program.
+    void declare_vars(const ooasm::BytecodeView &bc) {
+        ooasm::Interpreter(bc, cm).declare();
+    }
+
+    // Checks that every identifier used by the program has been declared.
+    static void link(const ooasm::BytecodeView &bc) {
+        ooasm::Linker::check(bc);
+    }
+
+    // Executes all functions that aren't declarations, through the summary of the
+    // program when it has one. A computer on the JIT, which builds verifying the JIT
+    // default to, always runs the code itself.
+    void execute_functions(const ooasm::BytecodeView &bc, ooasm::BackendCache &cache) {
+        if constexpr (wide) {
+            if (backend != ooasm::Backend::jit) {
+                const ooasm::Summary *summary = cache.get<ooasm::SummarizedProgram>().get(bc);
+                if (summary != nullptr && summary->apply(cm))
+                    return;
+            }
+
+            if (parallel)
+                parallel->execute(bc, cache.get<ooasm::ScheduledProgram>().get(bc), cm);
+            else
+                ooasm::execute(bc, cache.get<ooasm::NativeProgram>(), cm, backend);
+        } else {
+            (void) cache;
+            ooasm::Interpreter(bc, cm).execute();
+        }
+    }
+
+    // Returns the code of a program or a program image for words of this computer.
+    template<typename Program>
+    static ooasm::BytecodeView code(const Program &p) {
+        if constexpr (wide)
+            return p.bytecode();
+        else
+            return p.bytecode(sizeof(Word) * 8);
+    }
+
+    // Boots a program or a program image.
+    template<typename Program>
+    void boot_program(const Program &p) {
+        const ooasm::BytecodeView bc = code(p);
+        cm.setup();
+        cm.vars = p.addresses();
+        declare_vars(bc);
+        link(bc);
+        execute_functions(bc, p.backend_cache());
+    }
+
+    // Boots a program or a program image through the cache, keeping failures that come
+    // from the program itself, and rethrowing them on every boot that hits.
+    template<typename Program>
+    void boot_cached(const Program &p, ooasm::ResultCache &cache) {
+        std::exception_ptr failure;
+        if (!cache.restore(p.fingerprint(), cm, failure)) {
+            try {
+                boot_program(p);
+            } catch (std::invalid_argument &) {
+                failure = std::current_exception();
+            }
+            cache.store(p.fingerprint(), cm, failure);
+        } else {
+            cm.vars = p.addresses();
+        }
+        if (failure)
+            std::rethrow_exception(failure);
+    }
+
+    // Boots the program of an observer of the interpreter, lowered but not optimized.
+    template<typename Observer>
+    void boot_observed(Observer &observer) {
+        cm.setup();
+        cm.vars = ooasm::Linker::addresses(observer.bytecode());
+        ooasm::Interpreter interpreter(observer.bytecode(), cm, &observer);
+        interpreter.declare();
+        link(observer.bytecode());
+        interpreter.execute();
+    }
+
+public:
+    // The parallel backend runs on [threads] threads, one per core if it is zero.
+    explicit BasicComputer(ooasm::ComputerMemory::vars_size_t size, ooasm::Backend _backend = ooasm::default_backend,
+                           std::size_t threads = 0)
+            : backend(_backend) {
+        cm.size = size;
+        if (wide && backend == ooasm::Backend::parallel)
+            parallel = std::make_unique<ooasm::ParallelExecutor>(threads);
+    }
+
+    // Copies start threads of their own, as many as those of the computer copied.
+    BasicComputer(const BasicComputer &other)
+            : cm(other.cm), backend(other.backend), published(other.published), published_size(other.published_size) {
+        if (other.parallel)
+            parallel = std::make_unique<ooasm::ParallelExecutor>(other.parallel->workers());
+    }
+
+    BasicComputer(BasicComputer &&) = default;
+
+    BasicComputer &operator=(const BasicComputer &other) {
+        if (this != &other)
+            *this = BasicComputer(other);
+        return *this;
+    }
+
+    BasicComputer &operator=(BasicComputer &&) = default;
+
+    void boot(program &p) {
+        boot_program(p);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    // Boots a program image, see program_image.h. Images hold code for 64-bit words.
+    void boot(const ooasm::MappedProgram &p) {
+        static_assert(wide, "Program images hold code optimized for 64-bit words");
+        boot_program(p);
+    }
+#endif
+
+    // Boots the program, or restores what a boot of it on memory of the same size left,
+    // see result_cache.h.
+    void boot(program &p, ooasm::ResultCache &cache) {
+        boot_cached(p, cache);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    void boot(const ooasm::MappedProgram &p, ooasm::ResultCache &cache) {
+        static_assert(wide, "Program images hold code optimized for 64-bit words");
+        boot_cached(p, cache);
+    }
+#endif
+
+    // Runs the program from the state the last boot, resume or restore left, instead of
+    // from zeroed memory, so that different tails run from one shared prefix. Variables
+    // are linked by identifier: declarations of identifiers already declared are skipped,
+    // in any order, and the others are declared past them. Throws an error if the program
+    // uses an identifier declared by neither. Optimized code relies on starting from
+    // zeroed memory, so the program is interpreted as lowered.
+    void resume(const program &p) {
+        ooasm::Bytecode bc = p.assembled();
+        for (const auto &d : bc.declarations) {
+            const ooasm::identifier_t &id = bc.symbols[d.symbol];
+            if (!cm.vars || cm.vars->count(id) == 0)
+                cm.store(cm.add(id)) = ooasm::wrap<Word>(d.value);
+        }
+        ooasm::Linker::resolve(bc, cm.vars.get());
+        ooasm::Linker::bind(bc);
+        link(bc);
+        ooasm::Interpreter(bc, cm).execute();
+    }
+
+    // Takes a snapshot of memory, variables and flags, see snapshot.h.
+    ooasm::Snapshot snapshot() {
+        return ooasm::Snapshot::take(cm);
+    }
+
+    // Returns to the state of a snapshot, with memory of its size.
+    void restore(const ooasm::Snapshot &s) {
+        s.restore(cm);
+    }
+
+    // Boots an edited program from the last checkpoint its edits left, see editable.h.
+    void boot(ooasm::EditableProgram &p) {
+        cm.setup();
+        p.boot(cm);
+    }
+
+    // Boots the program of the profiler and adds the boot to its profile, see profiler.h.
+    void boot(ooasm::Profiler &profiler) {
+        profiler.start();
+        try {
+            boot_observed(profiler);
+        } catch (...) {
+            profiler.stop();
+            throw;
+        }
+        profiler.stop();
+    }
+
+    // Boots the program of the tracer, recording every instruction it runs, see tracer.h.
+    void boot(ooasm::Tracer &tracer) {
+        boot_observed(tracer);
+    }
+
+    // Boots a program pulled element by element from [next], a callable returning an
+    // empty pointer once the program ends, holding [chunk] elements at a time.
+    // Declarations have to come first, see stream.h.
+    template<typename Source>
+    void boot_stream(Source &&next, std::size_t chunk = ooasm::Stream::default_chunk) {
+        cm.setup();
+        ooasm::Stream(cm).run(next, chunk);
+    }
+
+    // Boots a program streamed from the range [first, last) of elements.
+    template<typename Iterator>
+    void boot_stream(Iterator first, Iterator last, std::size_t chunk = ooasm::Stream::default_chunk) {
+        boot_stream([&]() -> std::shared_ptr<ooasm::Function> {
+            return first == last ? nullptr : *first++;
+        }, chunk);
+    }
+
+    void memory_dump(std::ostream &os) const {
+        ooasm::write_text(os, cm.mem.begin(), cm.mem.end());
+    }
+
+    // Dumps memory as text or as a binary image, see memory_image.h.
+    void memory_dump(std::ostream &os, ooasm::dump_format format) const {
+        if (format == ooasm::dump_format::binary)
+            ooasm::write_image(os, cm.mem.begin(), cm.mem.end());
+        else
+            memory_dump(os);
+    }
+
+    // Dumps the cells changed since the previous delta dump, see memory_image.h.
+    // The first delta, and the first after a change of size, holds every non-zero cell;
+    // the following ones cost as much as the cells written in between.
+    void memory_dump_delta(std::ostream &os) {
+        ooasm::MemoryDelta delta;
+        delta.size = cm.mem.size();
+
+        if (!cm.track_writes || published_size != cm.mem.size()) {
+            delta.full = true;
+            published.clear();
+            cm.take_written();
+            cm.track_writes = true;
+            // Logged as written, so that the next setup() reports them zeroed.
+            for (ooasm::ComputerMemory::vars_size_t i = 0; i < cm.mem.size(); ++i) {
+                if (cm.mem[i] != 0) {
+                    delta.changes.emplace_back(i, cm.mem[i]);
+                    cm.log(i);
+                }
+            }
+        } else {
+            for (auto i : cm.take_written()) {
+                if (i >= cm.mem.size())
+                    continue;
+
+                auto it = published.find(i);
+                ooasm::memory_word_t before = it == published.end() ? 0 : it->second;
+                if (cm.mem[i] != before)
+                    delta.changes.emplace_back(i, cm.mem[i]);
+            }
+        }
+
+        for (const auto &[address, value] : delta.changes)
+            published[address] = value;
+        published_size = cm.mem.size();
+
+        ooasm::write_delta(os, delta);
+    }
+};
+
+using Computer = BasicComputer<>;
+
 #endif //OOASM_COMPUTER_H
\ No newline at end of file
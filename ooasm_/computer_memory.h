@@ -2,88 +2,222 @@
 #define OOASM_COMPUTER_MEMORY_H
 
 // Memory of the computer.
+#include "storage.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <vector>
 #include <unordered_map>
+#include <utility>
 
 namespace ooasm {
     using flag_t = bool;
     using memory_word_t = int64_t;
     using identifier_t = std::string;
 
-    struct ComputerMemory {
-        using memory_t = std::vector<memory_word_t>;
-        using vars_memory_t = std::unordered_map<identifier_t, memory_t::size_type>;
+    struct SnapshotState;
+
+    // Values of programs are 64-bit. Memory of narrower words holds them modulo 2^N as
+    // two's complement, so arithmetic on it wraps around at its own width, and flags
+    // follow the wrapped result.
+    template<typename Word>
+    constexpr Word wrap(memory_word_t value) noexcept {
+        return static_cast<Word>(static_cast<std::make_unsigned_t<Word>>(static_cast<uint64_t>(value)));
+    }
+
+    // Memory of words of type [Word]: int64_t, int32_t or int16_t. Only addresses read
+    // from cells are bounded by the width of words, static addresses are not.
+    template<typename Word>
+    struct BasicComputerMemory {
+        static_assert(std::is_integral_v<Word> && std::is_signed_v<Word> && sizeof(Word) >= 2 && sizeof(Word) <= 8,
+                      "Words are signed integers of 16 to 64 bits");
+
+        using word_t = Word;
+        using memory_t = Storage<Word>;
+        using vars_memory_t = std::unordered_map<identifier_t, typename memory_t::size_type>;
         using vars_size_t = typename vars_memory_t::size_type;
 
-        vars_memory_t vars;
+        // Writes are tracked in pages of 2^page_shift cells (4 KiB of 64-bit words).
+        static constexpr vars_size_t page_shift = 9;
+
+        // Addresses of the variables declared since the last setup, by identifier. Tables
+        // are shared with the programs booted and with snapshots, and copied before a
+        // variable is added to one that is shared.
+        std::shared_ptr<vars_memory_t> vars;
         memory_t mem;
-        flag_t ZF = false;
-        flag_t SF = false;
+        // Result of the last arithmetic operation. Flags are derived from it only when
+        // read, and it starts with a value that leaves both of them unset.
+        Word last_result = 1;
         vars_size_t last_index = 0;
         vars_size_t size = -1;
 
+        // Pages written since the last setup, as a bitmap and as a list.
+        std::vector<uint64_t> dirty;
+        std::vector<vars_size_t> dirty_pages;
+
+        // Snapshot the memory was last saved to or restored from since the last setup,
+        // see snapshot.h, and the pages written since then, as a bitmap and as a list.
+        // They are a subset of the dirty pages.
+        std::shared_ptr<const SnapshotState> origin;
+        std::vector<uint64_t> unsaved;
+        std::vector<vars_size_t> unsaved_pages;
+
+        // When [track_writes] is set, cells written during this boot and cells zeroed
+        // by setup() since the last take_written(). Logs are sorted and deduplicated
+        // whenever they double, so they stay proportional to distinct cells written.
+        bool track_writes = false;
+        std::vector<vars_size_t> written;
+        std::vector<vars_size_t> zeroed;
+
+        // Addresses of dynamic writes done by native code, see jit.h.
+        std::vector<vars_size_t> dynamic_writes;
+
+        // Prepares zeroed memory for a new boot. When the size has not changed, the buffer
+        // of the previous boot is reused and only the pages it wrote are zeroed again.
+        // Untouched pages of a large memory are never committed at all.
         void setup() {
-            vars = vars_memory_t();
-            mem = memory_t(size);
+            vars.reset();
+            last_index = 0;
+            last_result = 1;
+
+            if (track_writes) {
+                zeroed.insert(zeroed.end(), written.begin(), written.end());
+                written.clear();
+                compact(zeroed);
+            }
+
+            origin.reset();
+            settle();
+            if (mem.size() != size || (dirty_pages.size() << page_shift) >= size / 2) {
+                mem.assign(size, 0);
+                dirty.assign(((size >> page_shift) >> 6) + 1, 0);
+                unsaved.assign(dirty.size(), 0);
+            } else {
+                for (auto page : dirty_pages) {
+                    vars_size_t from = page << page_shift;
+                    vars_size_t to = std::min(size, from + (vars_size_t(1) << page_shift));
+                    mem.zero(from, to);
+                    dirty[page >> 6] = 0;
+                }
+            }
+            dirty_pages.clear();
         }
 
         // Assigns the identifier to one of memory's cells.
         // Throws an error if there are more assigned identifiers than memory's cells.
         vars_size_t add(const identifier_t& id) {
+            vars_size_t index = allocate();
+            if (!vars)
+                vars = std::make_shared<vars_memory_t>();
+            else if (vars.use_count() > 1)
+                vars = std::make_shared<vars_memory_t>(*vars);
+            vars->emplace(id, index);
+            return index;
+        }
+
+        // Assigns the next cell to a variable whose identifier is already resolved.
+        // Throws an error if there are more variables than memory's cells.
+        vars_size_t allocate() {
             if (last_index == size)
                 throw std::invalid_argument("Too many variables");
 
-            if (vars.find(id) == vars.end())
-                vars[id] = last_index;
-
             return last_index++;
         }
 
         // Finds which index of the memory identifier is assigned to and returns it.
         // Throws an error if it can't find it.
         [[nodiscard]] vars_size_t idx(const identifier_t& id) const {
-            auto it = vars.find(id);
-
-            if (it != vars.end())
-                return it->second;
-            else
-                throw std::invalid_argument("Variable not found");
+            if (vars) {
+                auto it = vars->find(id);
+                if (it != vars->end())
+                    return it->second;
+            }
+            throw std::invalid_argument("Variable not found");
         }
 
         // Returns memory at index [index]. Throws an error if it is out of bounds.
-        memory_word_t &at(vars_size_t index) {
-            if (index > size)
+        Word &at(vars_size_t index) {
+            if (index >= size)
                 throw std::invalid_argument("Out of bounds");
 
             return mem[index];
         }
 
-        // Sets the flag ZF based on last changed value.
-        void set_flag_ZF(memory_word_t value) {
-            ZF = value == 0;
+        // Marks the page holding cell [index] as written.
+        void mark(vars_size_t index) {
+            vars_size_t page = index >> page_shift;
+            uint64_t bit = uint64_t(1) << (page & 63);
+            if (!(unsaved[page >> 6] & bit)) {
+                unsaved[page >> 6] |= bit;
+                unsaved_pages.push_back(page);
+                if (!(dirty[page >> 6] & bit)) {
+                    dirty[page >> 6] |= bit;
+                    dirty_pages.push_back(page);
+                }
+            }
         }
 
-        // Sets the flag SF based on last changed value.
-        void set_flag_SF(memory_word_t value) {
-            SF = value < 0;
+        // Forgets which pages were written since the memory was last saved or restored.
+        void settle() {
+            for (auto page : unsaved_pages)
+                unsaved[page >> 6] = 0;
+            unsaved_pages.clear();
+        }
+
+        // Returns memory at index [index] to be written. Throws an error if it is out of bounds.
+        Word &store(vars_size_t index) {
+            at(index);
+            return store_unchecked(index);
+        }
+
+        // Returns memory at index [index], known to be in bounds, to be written.
+        Word &store_unchecked(vars_size_t index) {
+            mark(index);
+            if (track_writes)
+                log(index);
+            return mem[index];
+        }
+
+        void log(vars_size_t index) {
+            written.push_back(index);
+            if (written.size() >= 4096 && (written.size() & (written.size() - 1)) == 0)
+                compact(written);
+        }
+
+        static void compact(std::vector<vars_size_t> &cells) {
+            std::sort(cells.begin(), cells.end());
+            cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+        }
+
+        // Returns the sorted cells that may have changed since the previous call:
+        // those written during this boot and those zeroed by setup() in between.
+        std::vector<vars_size_t> take_written() {
+            std::vector<vars_size_t> cells = std::exchange(zeroed, {});
+            cells.insert(cells.end(), written.begin(), written.end());
+            compact(cells);
+            return cells;
         }
 
         // Sets up both flags based on last changed value.
-        void set_flags(memory_word_t value) {
-            set_flag_ZF(value);
-            set_flag_SF(value);
+        void set_flags(Word value) {
+            last_result = value;
         }
 
         // Checks if flag ZF is set.
-        bool is_flag_ZF_set() const {
-            return ZF;
+        [[nodiscard]] bool is_flag_ZF_set() const {
+            return last_result == 0;
         }
 
         // Checks if flag SF is set.
-        bool is_flag_SF_set() const {
-            return SF;
+        [[nodiscard]] bool is_flag_SF_set() const {
+            return last_result < 0;
         }
     };
+
+    using ComputerMemory = BasicComputerMemory<memory_word_t>;
 }
 
 #endif //OOASM_COMPUTER_MEMORY_H
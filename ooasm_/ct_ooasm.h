@@ -0,0 +1,404 @@
+#ifndef OOASM_CT_OOASM_H
+#define OOASM_CT_OOASM_H
+
+// Compile-time front end of OOAsm. Elements of the language are plain values whose
+// types encode the shape of the program, so a program can be run by a constexpr
+// interpreter and checked with static_assert, or run at run time as straight-line
+// code without virtual calls nor allocations:
+//
+//   constexpr auto p = ct::program(ct::dec(ct::mem(ct::num(1))), ct::ones(ct::mem(ct::num(0))));
+//   static_assert(ct::boot<2>(p).memory_dump() == "1 -1 ");
+//
+// Errors are reported with the same exceptions as the run-time front end, which
+// makes them compilation errors when the program is evaluated in a constant expression.
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace ooasm::ct {
+    using memory_word_t = int64_t;
+    using size_type = std::size_t;
+
+    // Checks whether given input is a valid identifier. Throws an error if it is not.
+    constexpr const char *check(const char *input) {
+        if (input == nullptr || input[0] == '\0')
+            throw std::invalid_argument("Input should be not empty nor NULL nor of length over 10");
+
+        size_type length = 0;
+        while (input[length] != '\0')
+            ++length;
+
+        if (length > 10)
+            throw std::invalid_argument("Input should be not empty nor NULL nor of length over 10");
+
+        return input;
+    }
+
+    constexpr bool same_identifier(const char *a, const char *b) {
+        while (*a != '\0' && *a == *b) {
+            ++a;
+            ++b;
+        }
+
+        return *a == *b;
+    }
+
+    // Text of a memory dump, comparable with the output of Computer::memory_dump.
+    template<size_type N>
+    class Dump {
+    private:
+        static constexpr size_type word_length = 21; // "-9223372036854775808 "
+
+        char text[N * word_length + 1] = {};
+        size_type length = 0;
+
+    public:
+        constexpr void append(memory_word_t word) {
+            char digits[word_length] = {};
+            size_type count = 0;
+            auto magnitude = static_cast<uint64_t>(word);
+            if (word < 0)
+                magnitude = ~magnitude + 1;
+
+            do {
+                digits[count++] = static_cast<char>('0' + magnitude % 10);
+                magnitude /= 10;
+            } while (magnitude != 0);
+
+            if (word < 0)
+                text[length++] = '-';
+            while (count > 0)
+                text[length++] = digits[--count];
+            text[length++] = ' ';
+        }
+
+        [[nodiscard]] constexpr const char *c_str() const noexcept {
+            return text;
+        }
+
+        constexpr bool operator==(const char *other) const {
+            for (size_type i = 0; i < length; ++i) {
+                if (other[i] != text[i])
+                    return false;
+            }
+
+            return other[length] == '\0';
+        }
+
+        constexpr bool operator!=(const char *other) const {
+            return !(*this == other);
+        }
+    };
+
+    // Memory of the computer with [N] cells, usable in constant expressions.
+    template<size_type N>
+    class Memory {
+    private:
+        static constexpr size_type capacity = N == 0 ? 1 : N;
+
+        memory_word_t mem[capacity] = {};
+        const char *vars[capacity] = {};
+        size_type last_index = 0;
+        bool ZF = false;
+        bool SF = false;
+
+    public:
+        // Assigns the identifier to one of memory's cells.
+        // Throws an error if there are more assigned identifiers than memory's cells.
+        constexpr size_type add(const char *id) {
+            if (last_index == N)
+                throw std::invalid_argument("Too many variables");
+
+            vars[last_index] = id;
+            return last_index++;
+        }
+
+        // Finds which index of the memory identifier is assigned to and returns it.
+        // Throws an error if it can't find it.
+        [[nodiscard]] constexpr size_type idx(const char *id) const {
+            for (size_type i = 0; i < last_index; ++i) {
+                if (same_identifier(vars[i], id))
+                    return i;
+            }
+
+            throw std::invalid_argument("Variable not found");
+        }
+
+        // Returns memory at index [index]. Throws an error if it is out of bounds.
+        constexpr memory_word_t &at(size_type index) {
+            if (index >= N)
+                throw std::invalid_argument("Out of bounds");
+
+            return mem[index];
+        }
+
+        constexpr void set_flags(memory_word_t value) {
+            ZF = value == 0;
+            SF = value < 0;
+        }
+
+        [[nodiscard]] constexpr bool is_flag_ZF_set() const {
+            return ZF;
+        }
+
+        [[nodiscard]] constexpr bool is_flag_SF_set() const {
+            return SF;
+        }
+
+        [[nodiscard]] constexpr Dump<N> memory_dump() const {
+            Dump<N> dump;
+            for (size_type i = 0; i < N; ++i)
+                dump.append(mem[i]);
+
+            return dump;
+        }
+    };
+
+    // R-values: numeric literal, effective address of a variable and memory cell.
+    class Num {
+    private:
+        memory_word_t value;
+    public:
+        constexpr explicit Num(memory_word_t val) : value(val) {}
+
+        template<size_type N>
+        constexpr memory_word_t get_value(Memory<N> &) const {
+            return value;
+        }
+    };
+
+    class Lea {
+    private:
+        const char *id;
+    public:
+        constexpr explicit Lea(const char *_id) : id(check(_id)) {}
+
+        template<size_type N>
+        constexpr memory_word_t get_value(Memory<N> &mem) const {
+            return static_cast<memory_word_t>(mem.idx(id));
+        }
+    };
+
+    template<typename R>
+    class Mem {
+    private:
+        R rval;
+    public:
+        constexpr explicit Mem(R x) : rval(x) {}
+
+        template<size_type N>
+        constexpr memory_word_t get_value(Memory<N> &mem) const {
+            return mem.at(static_cast<size_type>(rval.get_value(mem)));
+        }
+
+        template<size_type N>
+        constexpr memory_word_t &get_reference(Memory<N> &mem) const {
+            return mem.at(static_cast<size_type>(rval.get_value(mem)));
+        }
+    };
+
+    template<typename T>
+    struct is_lvalue : std::false_type {};
+
+    template<typename R>
+    struct is_lvalue<Mem<R>> : std::true_type {};
+
+    template<typename T>
+    struct is_rvalue : std::bool_constant<is_lvalue<T>::value ||
+                                          std::is_same_v<T, Num> || std::is_same_v<T, Lea>> {};
+
+    // Instructions. Declarations report themselves through [definition].
+    class Data {
+    private:
+        const char *id;
+        Num value;
+    public:
+        static constexpr bool definition = true;
+
+        constexpr Data(const char *input, Num _num) : id(check(input)), value(_num) {}
+
+        template<size_type N>
+        constexpr void execute(Memory<N> &mem) const {
+            mem.at(mem.add(id)) = value.get_value(mem);
+        }
+    };
+
+    template<typename L, typename R>
+    class Mov {
+    private:
+        L lval;
+        R rval;
+    public:
+        static constexpr bool definition = false;
+
+        constexpr Mov(L _lval, R _rval) : lval(_lval), rval(_rval) {}
+
+        template<size_type N>
+        constexpr void execute(Memory<N> &mem) const {
+            memory_word_t value = rval.get_value(mem);
+            lval.get_reference(mem) = value;
+        }
+    };
+
+    // Add and Sub when [negate] is false and true respectively.
+    template<typename L, typename R, bool negate>
+    class Arithmetic {
+    private:
+        L lval;
+        R rval;
+    public:
+        static constexpr bool definition = false;
+
+        constexpr Arithmetic(L _lval, R _rval) : lval(_lval), rval(_rval) {}
+
+        template<size_type N>
+        constexpr void execute(Memory<N> &mem) const {
+            auto &lref = lval.get_reference(mem);
+            auto value = static_cast<uint64_t>(rval.get_value(mem));
+            auto result = static_cast<uint64_t>(lref);
+            result = negate ? result - value : result + value;
+            lref = static_cast<memory_word_t>(result);
+            mem.set_flags(lref);
+        }
+    };
+
+    // One, Ones and Onez for [flag] equal to none, SF and ZF respectively.
+    enum class flag { none, SF, ZF };
+
+    template<typename L, flag f>
+    class Flagged {
+    private:
+        L lval;
+    public:
+        static constexpr bool definition = false;
+
+        constexpr explicit Flagged(L _lval) : lval(_lval) {}
+
+        template<size_type N>
+        constexpr void execute(Memory<N> &mem) const {
+            if constexpr (f == flag::SF) {
+                if (!mem.is_flag_SF_set())
+                    return;
+            } else if constexpr (f == flag::ZF) {
+                if (!mem.is_flag_ZF_set())
+                    return;
+            }
+
+            lval.get_reference(mem) = 1;
+        }
+    };
+
+    template<typename... Instructions>
+    class Program {
+    private:
+        std::tuple<Instructions...> instructions;
+
+        template<bool definitions, size_type N, size_type... I>
+        constexpr void run(Memory<N> &mem, std::index_sequence<I...>) const {
+            (void) mem;
+            ((Instructions::definition == definitions ? std::get<I>(instructions).execute(mem) : void()), ...);
+        }
+
+    public:
+        constexpr explicit Program(Instructions... ins) : instructions(ins...) {}
+
+        // Executes all declarations of the program, then all remaining instructions.
+        template<size_type N>
+        constexpr void boot(Memory<N> &mem) const {
+            run<true>(mem, std::index_sequence_for<Instructions...>());
+            run<false>(mem, std::index_sequence_for<Instructions...>());
+        }
+    };
+
+    template<size_type N>
+    class Computer {
+    private:
+        Memory<N> cm;
+    public:
+        template<typename... Instructions>
+        constexpr void boot(const Program<Instructions...> &p) {
+            cm = Memory<N>();
+            p.boot(cm);
+        }
+
+        [[nodiscard]] constexpr Dump<N> memory_dump() const {
+            return cm.memory_dump();
+        }
+    };
+
+    // Actual elements of OOASM language
+    constexpr Num num(memory_word_t val) {
+        return Num(val);
+    }
+
+    constexpr Lea lea(const char *_id) {
+        return Lea(_id);
+    }
+
+    template<typename R, typename = std::enable_if_t<is_rvalue<R>::value>>
+    constexpr Mem<R> mem(R x) {
+        return Mem<R>(x);
+    }
+
+    constexpr Data data(const char *input, Num _num) {
+        return Data(input, _num);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<is_lvalue<L>::value && is_rvalue<R>::value>>
+    constexpr Mov<L, R> mov(L _lval, R _rval) {
+        return Mov<L, R>(_lval, _rval);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<is_lvalue<L>::value && is_rvalue<R>::value>>
+    constexpr Arithmetic<L, R, false> add(L _lval, R _rval) {
+        return Arithmetic<L, R, false>(_lval, _rval);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<is_lvalue<L>::value && is_rvalue<R>::value>>
+    constexpr Arithmetic<L, R, true> sub(L _lval, R _rval) {
+        return Arithmetic<L, R, true>(_lval, _rval);
+    }
+
+    template<typename L, typename = std::enable_if_t<is_lvalue<L>::value>>
+    constexpr Arithmetic<L, Num, false> inc(L _lval) {
+        return Arithmetic<L, Num, false>(_lval, Num(1));
+    }
+
+    template<typename L, typename = std::enable_if_t<is_lvalue<L>::value>>
+    constexpr Arithmetic<L, Num, true> dec(L _lval) {
+        return Arithmetic<L, Num, true>(_lval, Num(1));
+    }
+
+    template<typename L, typename = std::enable_if_t<is_lvalue<L>::value>>
+    constexpr Flagged<L, flag::none> one(L _lval) {
+        return Flagged<L, flag::none>(_lval);
+    }
+
+    template<typename L, typename = std::enable_if_t<is_lvalue<L>::value>>
+    constexpr Flagged<L, flag::SF> ones(L _lval) {
+        return Flagged<L, flag::SF>(_lval);
+    }
+
+    template<typename L, typename = std::enable_if_t<is_lvalue<L>::value>>
+    constexpr Flagged<L, flag::ZF> onez(L _lval) {
+        return Flagged<L, flag::ZF>(_lval);
+    }
+
+    template<typename... Instructions>
+    constexpr Program<Instructions...> program(Instructions... ins) {
+        return Program<Instructions...>(ins...);
+    }
+
+    // Boots a program on a fresh computer with [N] cells of memory and returns the computer.
+    template<size_type N, typename... Instructions>
+    constexpr Computer<N> boot(const Program<Instructions...> &p) {
+        Computer<N> computer;
+        computer.boot(p);
+        return computer;
+    }
+}
+
+#endif //OOASM_CT_OOASM_H
@@ -0,0 +1,271 @@
+#ifndef OOASM_EDITABLE_H
+#define OOASM_EDITABLE_H
+
+// Programs edited between boots, re-executed from the last state the edit left valid.
+#include "bytecode.h"
+#include "computer_memory.h"
+#include "interpreter.h"
+#include "linker.h"
+#include "ooasm.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ooasm {
+    // Program whose elements are appended, inserted, replaced and erased one at a time,
+    // see Computer::boot(EditableProgram &). Its code stays lowered and linked as edits
+    // come, and is interpreted as lowered, one instruction per function of the program.
+    //
+    // Boots take checkpoints of memory and flags as they go, once at least [interval]
+    // instructions and as many instructions as cells written have run since the last
+    // one, so that copying them costs no more than running the code did, and one at the
+    // end. An edit of an instruction drops the checkpoints after it, and the next boot
+    // resumes from the last one left: rebooting after an edit near the end runs only
+    // the instructions after the checkpoint. An edit of a declaration may move every
+    // variable, so the whole program is linked again and runs from scratch.
+    //
+    // Checkpoints are kept for one size of memory at a time.
+    class EditableProgram {
+    private:
+        struct Checkpoint {
+            std::size_t index;
+            memory_word_t last_result;
+            std::vector<ComputerMemory::vars_size_t> pages;
+            std::vector<memory_word_t> cells;
+        };
+
+        std::vector<std::shared_ptr<Function>> elements;
+        Bytecode bc;
+        // Addresses of the variables, by identifier.
+        std::shared_ptr<ComputerMemory::vars_memory_t> vars;
+        std::size_t unresolved = 0;
+        std::size_t interval;
+
+        std::vector<Checkpoint> checkpoints;
+        ComputerMemory::vars_size_t checkpoint_size = 0;
+        std::size_t resumed = 0;
+
+        static bool is_unresolved(mode m) noexcept {
+            return m == mode::sym || m == mode::sym_cell || m == mode::sym_indirect;
+        }
+
+        static bool is_unresolved(const Instruction &ins) noexcept {
+            return is_unresolved(ins.dst_mode) || is_unresolved(ins.src_mode);
+        }
+
+        // Lowers and links the whole program again.
+        void relink() {
+            Assembler as;
+            for (const auto &element : elements)
+                element->assemble(as);
+            bc = as.finish();
+            Linker::resolve(bc);
+            Linker::bind(bc);
+
+            vars = Linker::addresses(bc);
+            unresolved = static_cast<std::size_t>(std::count_if(bc.code.begin(), bc.code.end(), [](const auto &ins) {
+                return is_unresolved(ins);
+            }));
+            checkpoints.clear();
+        }
+
+        // Lowers a function that is not a declaration and links it with the variables
+        // declared by the program.
+        Instruction lower(const Function &f) const {
+            Assembler as;
+            f.assemble(as);
+            Bytecode one = as.finish();
+
+            Linker::resolve(one, vars.get());
+            return one.code[0];
+        }
+
+        // Returns the index of the instruction of the function at [position], or of the
+        // next one.
+        [[nodiscard]] std::size_t instruction(std::size_t position) const {
+            return static_cast<std::size_t>(std::count_if(elements.begin(), elements.begin() +
+                                                                             static_cast<std::ptrdiff_t>(position),
+                                                          [](const auto &e) { return !e->is_definition(); }));
+        }
+
+        // Drops checkpoints depending on instruction [index] and binds the code from it on.
+        void edited(std::size_t index) {
+            while (!checkpoints.empty() && checkpoints.back().index > index)
+                checkpoints.pop_back();
+
+            bc.unresolved = unresolved != 0;
+            uint64_t r = index == 0 ? 0 : bc.reach[index - 1];
+            for (std::size_t i = index; i < bc.code.size(); ++i) {
+                r = Linker::reach(r, bc.code[i]);
+                bc.reach[i] = r;
+            }
+        }
+
+        void check(std::size_t position, std::size_t end) const {
+            if (position >= end)
+                throw std::invalid_argument("No such element");
+        }
+
+        void take(std::size_t index, const ComputerMemory &cm) {
+            if (!checkpoints.empty() && checkpoints.back().index == index)
+                return;
+
+            Checkpoint c{index, cm.last_result, cm.dirty_pages, {}};
+            c.cells.reserve(c.pages.size() << ComputerMemory::page_shift);
+            for (auto page : c.pages) {
+                ComputerMemory::vars_size_t from = page << ComputerMemory::page_shift;
+                ComputerMemory::vars_size_t to = std::min(cm.mem.size(),
+                                                          from + (ComputerMemory::vars_size_t(1) << ComputerMemory::page_shift));
+                c.cells.insert(c.cells.end(), cm.mem.begin() + from, cm.mem.begin() + to);
+            }
+            checkpoints.push_back(std::move(c));
+        }
+
+        void restore(const Checkpoint &c, ComputerMemory &cm) const {
+            const memory_word_t *in = c.cells.data();
+            for (auto page : c.pages) {
+                ComputerMemory::vars_size_t from = page << ComputerMemory::page_shift;
+                ComputerMemory::vars_size_t to = std::min(cm.mem.size(),
+                                                          from + (ComputerMemory::vars_size_t(1) << ComputerMemory::page_shift));
+                cm.mark(from);
+                for (auto i = from; i < to; ++i, ++in) {
+                    cm.mem[i] = *in;
+                    if (cm.track_writes && *in != 0)
+                        cm.log(i);
+                }
+            }
+            cm.last_result = c.last_result;
+            cm.last_index = bc.declarations.size();
+        }
+
+    public:
+        explicit EditableProgram(std::size_t _interval = 4096) : interval(std::max<std::size_t>(_interval, 1)) {
+            relink();
+        }
+
+        EditableProgram(std::initializer_list<std::shared_ptr<Function>> init_list, std::size_t _interval = 4096)
+                : elements(init_list), interval(std::max<std::size_t>(_interval, 1)) {
+            relink();
+        }
+
+        explicit EditableProgram(std::vector<std::shared_ptr<Function>> _elements, std::size_t _interval = 4096)
+                : elements(std::move(_elements)), interval(std::max<std::size_t>(_interval, 1)) {
+            relink();
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return elements.size();
+        }
+
+        [[nodiscard]] const std::shared_ptr<Function> &at(std::size_t position) const {
+            check(position, elements.size());
+            return elements[position];
+        }
+
+        void append(std::shared_ptr<Function> element) {
+            insert(elements.size(), std::move(element));
+        }
+
+        // Inserts [element] before the one at [position]. Throws an error if there is
+        // no such position.
+        void insert(std::size_t position, std::shared_ptr<Function> element) {
+            check(position, elements.size() + 1);
+            bool definition = element->is_definition();
+            elements.insert(elements.begin() + static_cast<std::ptrdiff_t>(position), element);
+            if (definition)
+                return relink();
+
+            std::size_t index = instruction(position);
+            Instruction ins = lower(*element);
+            unresolved += is_unresolved(ins);
+            bc.code.insert(bc.code.begin() + static_cast<std::ptrdiff_t>(index), ins);
+            bc.reach.insert(bc.reach.begin() + static_cast<std::ptrdiff_t>(index), 0);
+            edited(index);
+        }
+
+        // Replaces the element at [position]. Throws an error if there is none.
+        void replace(std::size_t position, std::shared_ptr<Function> element) {
+            check(position, elements.size());
+            bool definition = element->is_definition() || elements[position]->is_definition();
+            elements[position] = element;
+            if (definition)
+                return relink();
+
+            std::size_t index = instruction(position);
+            Instruction ins = lower(*element);
+            unresolved += is_unresolved(ins);
+            unresolved -= is_unresolved(bc.code[index]);
+            bc.code[index] = ins;
+            edited(index);
+        }
+
+        // Erases the element at [position]. Throws an error if there is none.
+        void erase(std::size_t position) {
+            check(position, elements.size());
+            bool definition = elements[position]->is_definition();
+            elements.erase(elements.begin() + static_cast<std::ptrdiff_t>(position));
+            if (definition)
+                return relink();
+
+            std::size_t index = instruction(position);
+            unresolved -= is_unresolved(bc.code[index]);
+            bc.code.erase(bc.code.begin() + static_cast<std::ptrdiff_t>(index));
+            bc.reach.erase(bc.reach.begin() + static_cast<std::ptrdiff_t>(index));
+            edited(index);
+        }
+
+        [[nodiscard]] const Bytecode &bytecode() const noexcept {
+            return bc;
+        }
+
+        // Returns how many checkpoints are kept.
+        [[nodiscard]] std::size_t checkpoint_count() const noexcept {
+            return checkpoints.size();
+        }
+
+        // Returns the index of the instruction the last boot resumed from, zero if it
+        // ran from scratch.
+        [[nodiscard]] std::size_t resumed_from() const noexcept {
+            return resumed;
+        }
+
+        // Boots the program on memory prepared by setup(), from the last checkpoint taken
+        // on memory of the same size if there is one.
+        void boot(ComputerMemory &cm) {
+            if (cm.size != checkpoint_size) {
+                checkpoints.clear();
+                checkpoint_size = cm.size;
+            }
+
+            Interpreter interpreter(bc, cm);
+            cm.vars = vars;
+            resumed = 0;
+            if (!checkpoints.empty() && !bc.unresolved) {
+                restore(checkpoints.back(), cm);
+                resumed = checkpoints.back().index;
+            } else {
+                interpreter.declare();
+                Linker::check(bc);
+            }
+
+            std::size_t done = resumed;
+            while (done < bc.code.size()) {
+                std::size_t written = cm.dirty_pages.size() << ComputerMemory::page_shift;
+                std::size_t next = std::min(bc.code.size(), done + std::max(interval, written));
+                interpreter.execute(done, next);
+                done = next;
+                take(done, cm);
+            }
+            take(done, cm);
+        }
+    };
+}
+
+#endif //OOASM_EDITABLE_H
@@ -0,0 +1,222 @@
+#ifndef OOASM_INTERPRETER_H
+#define OOASM_INTERPRETER_H
+
+// Executes the bytecode of a program on the memory of the computer.
+#include "bytecode.h"
+#include "computer_memory.h"
+#include "linker.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ooasm {
+    // Observer of an interpreter that observes nothing. Interpreters without an observer
+    // have every call to one compiled out.
+    //
+    // Observers are told of every declaration(index) and instruction(index) before it
+    // runs, of every read(address) and write(address) of a cell once it is in bounds,
+    // and of the effect of every instruction that completes.
+    struct NullObserver {
+    };
+
+    // What an instruction did, told to observers with retired(index, effect) once it
+    // completes: the cell it wrote, unless it was a conditional write not taken, with
+    // its value before and after, and the result flags are read from.
+    struct Effect {
+        ComputerMemory::vars_size_t address = 0;
+        memory_word_t before = 0;
+        memory_word_t after = 0;
+        memory_word_t last_result = 0;
+        bool wrote = false;
+    };
+
+    // Runs on memory of any width of words, see BasicComputerMemory. Values the code
+    // holds, literals and values of declarations, are wrapped to the width of words
+    // when used, and values read from cells are sign-extended where used as addresses.
+    template<typename Observer = NullObserver, typename Word = memory_word_t>
+    class Interpreter {
+    private:
+        static constexpr bool observed = !std::is_same_v<Observer, NullObserver>;
+
+        using Memory = BasicComputerMemory<Word>;
+        using uword_t = std::make_unsigned_t<Word>;
+
+        BytecodeView bc;
+        Memory &cm;
+        Observer *observer;
+        Effect effect;
+        Word *written = nullptr;
+
+        void read(memory_word_t address) {
+            if constexpr (observed)
+                observer->read(static_cast<ComputerMemory::vars_size_t>(address));
+        }
+
+        void write(memory_word_t address) {
+            if constexpr (observed)
+                observer->write(static_cast<ComputerMemory::vars_size_t>(address));
+        }
+
+        // Reads the cell at [address]. Static addresses of the bound part of the code
+        // are known to fit in memory and are read [unchecked].
+        template<bool unchecked>
+        Word load(memory_word_t address) {
+            Word v;
+            if constexpr (unchecked)
+                v = cm.mem[static_cast<ComputerMemory::vars_size_t>(address)];
+            else
+                v = cm.at(address);
+            read(address);
+            return v;
+        }
+
+        // Follows [depth] - 1 memory references starting at [address]. Only the first
+        // one reads a static address.
+        template<bool unchecked>
+        memory_word_t follow(memory_word_t address, uint32_t depth) {
+            address = load<unchecked>(address);
+            while (--depth > 1)
+                address = load<false>(address);
+
+            return address;
+        }
+
+        // Returns the memory cell an l-value operand of linked code refers to, to be written,
+        // and to be read first if it is [modified].
+        template<bool unchecked, bool modified = false>
+        Word &reference(mode m, memory_word_t operand, uint32_t depth) {
+            memory_word_t address = m == mode::cell ? operand : follow<unchecked>(operand, depth);
+            Word *cell;
+            if (unchecked && m == mode::cell)
+                cell = &cm.store_unchecked(static_cast<ComputerMemory::vars_size_t>(address));
+            else
+                cell = &cm.store(address);
+
+            if constexpr (modified)
+                read(address);
+            write(address);
+            if constexpr (observed) {
+                effect.address = static_cast<ComputerMemory::vars_size_t>(address);
+                effect.before = *cell;
+                written = cell;
+            }
+            return *cell;
+        }
+
+        // Returns the value of an r-value operand of linked code.
+        template<bool unchecked>
+        Word value(mode m, memory_word_t operand, uint32_t depth) {
+            if (m == mode::imm)
+                return wrap<Word>(operand);
+            if (m == mode::cell)
+                return load<unchecked>(operand);
+
+            return load<false>(follow<unchecked>(operand, depth));
+        }
+
+        // Two's complement addition, well defined on overflow.
+        static Word wrapping_add(Word a, Word b) noexcept {
+            return static_cast<Word>(static_cast<uword_t>(static_cast<uword_t>(a) + static_cast<uword_t>(b)));
+        }
+
+        static Word wrapping_sub(Word a, Word b) noexcept {
+            return static_cast<Word>(static_cast<uword_t>(static_cast<uword_t>(a) - static_cast<uword_t>(b)));
+        }
+
+    public:
+        explicit Interpreter(const BytecodeView &_bc, BasicComputerMemory<Word> &_cm, Observer *_observer = nullptr)
+                : bc(_bc), cm(_cm), observer(_observer) {}
+
+        // Copies all variables to memory in order of declaration. Their identifiers were
+        // replaced with addresses when linking, so cells are not named at run time.
+        void declare() {
+            for (std::size_t i = 0; i < bc.declarations.size(); ++i) {
+                if constexpr (observed)
+                    observer->declaration(i);
+                auto address = cm.allocate();
+                cm.store(address) = wrap<Word>(bc.declarations[i].value);
+                write(static_cast<memory_word_t>(address));
+            }
+        }
+
+        // Runs the whole program: declarations, link step and instructions.
+        void run() {
+            declare();
+            Linker::check(bc);
+            execute();
+        }
+
+        // Executes all instructions in order. The code has to be linked. If it is also
+        // bound, instructions before the first one with a static address past the memory
+        // run without bounds checks on static addresses.
+        void execute() {
+            execute(0, bc.code.size());
+        }
+
+        // Executes instructions [begin, end) in order, as part of a whole execution.
+        void execute(std::size_t begin, std::size_t end) {
+            std::size_t bound = std::clamp(Linker::bound(bc, cm.mem.size()), begin, end);
+            for (std::size_t i = begin; i < bound; ++i)
+                step<true>(i);
+            for (std::size_t i = bound; i < end; ++i)
+                step<false>(i);
+        }
+
+    private:
+        template<bool unchecked>
+        void step(std::size_t index) {
+            if constexpr (observed)
+                observer->instruction(index);
+
+            operate<unchecked>(bc.code[index]);
+
+            if constexpr (observed) {
+                effect.wrote = written != nullptr;
+                if (effect.wrote)
+                    effect.after = *written;
+                effect.last_result = cm.last_result;
+                observer->retired(index, effect);
+                written = nullptr;
+            }
+        }
+
+        template<bool unchecked>
+        void operate(const Instruction &ins) {
+            switch (ins.op) {
+                case opcode::mov: {
+                    Word v = value<unchecked>(ins.src_mode, ins.src, ins.src_depth);
+                    reference<unchecked>(ins.dst_mode, ins.dst, ins.dst_depth) = v;
+                    break;
+                }
+                case opcode::add: {
+                    auto &lref = reference<unchecked, true>(ins.dst_mode, ins.dst, ins.dst_depth);
+                    lref = wrapping_add(lref, value<unchecked>(ins.src_mode, ins.src, ins.src_depth));
+                    if (ins.sets_flags)
+                        cm.set_flags(lref);
+                    break;
+                }
+                case opcode::sub: {
+                    auto &lref = reference<unchecked, true>(ins.dst_mode, ins.dst, ins.dst_depth);
+                    lref = wrapping_sub(lref, value<unchecked>(ins.src_mode, ins.src, ins.src_depth));
+                    if (ins.sets_flags)
+                        cm.set_flags(lref);
+                    break;
+                }
+                case opcode::one:
+                    reference<unchecked>(ins.dst_mode, ins.dst, ins.dst_depth) = 1;
+                    break;
+                case opcode::ones:
+                    if (cm.is_flag_SF_set())
+                        reference<unchecked>(ins.dst_mode, ins.dst, ins.dst_depth) = 1;
+                    break;
+                case opcode::onez:
+                    if (cm.is_flag_ZF_set())
+                        reference<unchecked>(ins.dst_mode, ins.dst, ins.dst_depth) = 1;
+                    break;
+            }
+        }
+    };
+}
+
+#endif //OOASM_INTERPRETER_H
@@ -0,0 +1,471 @@
+#ifndef OOASM_JIT_H
+#define OOASM_JIT_H
+
+// Translation of linked bytecode to native x86-64 code.
+//
+// The backend of a Computer is picked when it is constructed. It defaults to the JIT
+// when the program is compiled with -DOOASM_JIT, and to the interpreter otherwise.
+// Compiling with -DOOASM_JIT_VERIFY makes the JIT the default too and checks every
+// boot it runs against the interpreter, aborting on the first difference:
+//
+//   g++ -O2 -std=c++17 -DOOASM_JIT_VERIFY -Iooasm_ tests/move_mem.cc
+//
+// From the second boot of a program on, its summary (see summary.h) stands in for the
+// interpreter and the parallel backend, but never for the JIT. Computers of builds
+// verifying the JIT so check every boot of their programs, not only the first one.
+#include "backend_cache.h"
+#include "bytecode.h"
+#include "computer_memory.h"
+#include "interpreter.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define OOASM_JIT_AVAILABLE 1
+#endif
+
+namespace ooasm {
+    // The parallel backend runs independent instructions on several threads, see
+    // parallel.h. Where there is no Computer to own its threads, it interprets.
+    enum class Backend {
+        interpreter, jit, parallel
+    };
+
+#if defined(OOASM_JIT) || defined(OOASM_JIT_VERIFY)
+    constexpr Backend default_backend = Backend::jit;
+#else
+    constexpr Backend default_backend = Backend::interpreter;
+#endif
+
+    // State shared with native code, which refers to the fields by offset.
+    struct NativeContext {
+        memory_word_t *mem;                 // 0
+        uint64_t size;                      // 8
+        ComputerMemory::vars_size_t *writes; // 16
+        uint64_t written;                   // 24
+        memory_word_t last_result;          // 32
+    };
+
+#ifdef OOASM_JIT_AVAILABLE
+    // Encoder of the few x86-64 instructions native code is made of. Memory operands
+    // are [base + index * 8 + disp32], or [base + disp32] without an index.
+    class X64 {
+    public:
+        enum reg : int {
+            rax = 0, rcx = 1, rdx = 2, rsi = 6, rdi = 7, r8 = 8, r9 = 9, r10 = 10, r11 = 11
+        };
+
+        struct Address {
+            int base;
+            int index;
+            int32_t disp;
+        };
+
+        // Condition codes of jcc.
+        static constexpr uint8_t above_or_equal = 0x3, not_zero = 0x5, not_sign = 0x9;
+
+        std::vector<uint8_t> bytes;
+
+        void byte(uint8_t b) {
+            bytes.push_back(b);
+        }
+
+        void dword(uint32_t d) {
+            for (int i = 0; i < 4; ++i)
+                byte(static_cast<uint8_t>(d >> (8 * i)));
+        }
+
+        void qword(uint64_t q) {
+            dword(static_cast<uint32_t>(q));
+            dword(static_cast<uint32_t>(q >> 32));
+        }
+
+        // opcode reg, [address] or opcode [address], reg, depending on the opcode.
+        void op(uint8_t opcode, int reg, Address a) {
+            int index = a.index < 0 ? 0 : a.index;
+            byte(0x48 | ((reg & 8) >> 1) | ((index & 8) >> 2) | ((a.base & 8) >> 3));
+            byte(opcode);
+            if (a.index < 0) {
+                byte(static_cast<uint8_t>(0x80 | (reg & 7) << 3 | (a.base & 7)));
+                if ((a.base & 7) == 4)
+                    byte(0x24);
+            } else {
+                byte(static_cast<uint8_t>(0x84 | (reg & 7) << 3));
+                byte(static_cast<uint8_t>(0xC0 | (a.index & 7) << 3 | (a.base & 7)));
+            }
+            dword(static_cast<uint32_t>(a.disp));
+        }
+
+        // opcode rm, reg on registers.
+        void op(uint8_t opcode, int reg, int rm) {
+            byte(0x48 | ((reg & 8) >> 1) | ((rm & 8) >> 3));
+            byte(opcode);
+            byte(static_cast<uint8_t>(0xC0 | (reg & 7) << 3 | (rm & 7)));
+        }
+
+        void load(int reg, Address a) {
+            op(0x8B, reg, a);
+        }
+
+        void store(Address a, int reg) {
+            op(0x89, reg, a);
+        }
+
+        // Stores a sign-extended 32-bit literal.
+        void store_literal(Address a, int32_t imm) {
+            op(0xC7, 0, a);
+            dword(static_cast<uint32_t>(imm));
+        }
+
+        // add [address], reg or sub [address], reg.
+        void arithmetic(bool negate, Address a, int reg) {
+            op(negate ? 0x29 : 0x01, reg, a);
+        }
+
+        // add [address], imm or sub [address], imm with a sign-extended 32-bit literal.
+        void arithmetic_literal(bool negate, Address a, int32_t imm) {
+            op(0x81, negate ? 5 : 0, a);
+            dword(static_cast<uint32_t>(imm));
+        }
+
+        void move(int reg, uint64_t imm) {
+            byte(0x48 | ((reg & 8) >> 3));
+            byte(static_cast<uint8_t>(0xB8 + (reg & 7)));
+            qword(imm);
+        }
+
+        // cmp a, b
+        void compare(int a, int b) {
+            op(0x39, b, a);
+        }
+
+        void test(int reg) {
+            op(0x85, reg, reg);
+        }
+
+        void increment(int reg) {
+            op(0xFF, 0, reg);
+        }
+
+        // Emits a conditional jump and returns where its target goes.
+        std::size_t jump(uint8_t condition) {
+            byte(0x0F);
+            byte(0x80 | condition);
+            dword(0);
+            return bytes.size() - 4;
+        }
+
+        // Makes the jump at [at] go to the current position.
+        void land(std::size_t at) {
+            auto rel = static_cast<uint32_t>(bytes.size() - (at + 4));
+            std::memcpy(bytes.data() + at, &rel, 4);
+        }
+
+        void return_status(int32_t status) {
+            byte(0xB8);
+            dword(static_cast<uint32_t>(status));
+            byte(0xC3);
+        }
+    };
+#endif
+
+    // Native code of one program. It runs only on memory large enough for all static
+    // addresses of the code, so those are encoded as displacements from the memory base
+    // and never checked; on smaller memory the program fails at some static address and
+    // the interpreter runs it instead. Dynamic addresses are checked as they are computed,
+    // and an out-of-bounds one ends the code before the instruction writes anything.
+    //
+    // Registers: rsi - memory base, rdx - size, rcx - log of dynamic writes, r8 - length
+    // of the log, r9 - last arithmetic result, from which flags are read.
+    class NativeCode {
+    private:
+        using entry_t = int (*)(NativeContext *);
+
+        void *buffer = nullptr;
+        std::size_t length = 0;
+        entry_t entry = nullptr;
+        uint64_t reach = 0;
+        std::size_t dynamic_writes = 0;
+        std::vector<ComputerMemory::vars_size_t> static_pages;
+        std::vector<ComputerMemory::vars_size_t> static_cells;
+
+        NativeCode() = default;
+
+#ifdef OOASM_JIT_AVAILABLE
+        using Address = X64::Address;
+
+        static constexpr uint64_t max_displacement = std::numeric_limits<int32_t>::max() / sizeof(memory_word_t);
+
+        static bool fits(memory_word_t value) {
+            return value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max();
+        }
+
+        // Addresses a static cell, through r10 when it is too far for a displacement.
+        static Address cell(X64 &x, memory_word_t operand) {
+            auto a = static_cast<uint64_t>(operand);
+            if (a <= max_displacement)
+                return {X64::rsi, -1, static_cast<int32_t>(a * sizeof(memory_word_t))};
+
+            x.move(X64::r10, a);
+            return {X64::rsi, X64::r10, 0};
+        }
+
+        // Leaves in [reg] the address an indirect operand refers to, checked against the size.
+        static void follow(X64 &x, int reg, memory_word_t operand, uint32_t depth, std::vector<std::size_t> &failures) {
+            x.load(reg, cell(x, operand));
+            for (uint32_t i = 2; i < depth; ++i) {
+                x.compare(reg, X64::rdx);
+                failures.push_back(x.jump(X64::above_or_equal));
+                x.load(reg, {X64::rsi, reg, 0});
+            }
+            x.compare(reg, X64::rdx);
+            failures.push_back(x.jump(X64::above_or_equal));
+        }
+
+        // Returns the cell an l-value operand refers to. Dynamic ones are logged.
+        static Address destination(X64 &x, const Instruction &ins, std::vector<std::size_t> &failures) {
+            if (ins.dst_mode == mode::cell)
+                return cell(x, ins.dst);
+
+            follow(x, X64::r11, ins.dst, ins.dst_depth, failures);
+            x.store({X64::rcx, X64::r8, 0}, X64::r11);
+            x.increment(X64::r8);
+            return {X64::rsi, X64::r11, 0};
+        }
+
+        // Loads the value of an r-value operand to rax.
+        static void source(X64 &x, const Instruction &ins, std::vector<std::size_t> &failures) {
+            if (ins.src_mode == mode::imm) {
+                x.move(X64::rax, static_cast<uint64_t>(ins.src));
+            } else if (ins.src_mode == mode::cell) {
+                x.load(X64::rax, cell(x, ins.src));
+            } else {
+                follow(x, X64::rax, ins.src, ins.src_depth, failures);
+                x.load(X64::rax, {X64::rsi, X64::rax, 0});
+            }
+        }
+
+        static void translate(X64 &x, const Instruction &ins, std::vector<std::size_t> &failures) {
+            bool literal = ins.src_mode == mode::imm && fits(ins.src);
+
+            switch (ins.op) {
+                case opcode::mov: {
+                    if (!literal)
+                        source(x, ins, failures);
+                    Address d = destination(x, ins, failures);
+                    if (literal)
+                        x.store_literal(d, static_cast<int32_t>(ins.src));
+                    else
+                        x.store(d, X64::rax);
+                    break;
+                }
+                case opcode::add:
+                case opcode::sub: {
+                    if (!literal)
+                        source(x, ins, failures);
+                    Address d = destination(x, ins, failures);
+                    if (literal)
+                        x.arithmetic_literal(ins.op == opcode::sub, d, static_cast<int32_t>(ins.src));
+                    else
+                        x.arithmetic(ins.op == opcode::sub, d, X64::rax);
+                    if (ins.sets_flags)
+                        x.load(X64::r9, d);
+                    break;
+                }
+                case opcode::one:
+                    x.store_literal(destination(x, ins, failures), 1);
+                    break;
+                case opcode::ones:
+                case opcode::onez: {
+                    x.test(X64::r9);
+                    std::size_t skip = x.jump(ins.op == opcode::ones ? X64::not_sign : X64::not_zero);
+                    x.store_literal(destination(x, ins, failures), 1);
+                    x.land(skip);
+                    break;
+                }
+            }
+        }
+
+        void assemble(const BytecodeView &bc) {
+            X64 x;
+            std::vector<std::size_t> failures;
+
+            x.load(X64::rsi, {X64::rdi, -1, 0});
+            x.load(X64::rdx, {X64::rdi, -1, 8});
+            x.load(X64::rcx, {X64::rdi, -1, 16});
+            x.load(X64::r8, {X64::rdi, -1, 24});
+            x.load(X64::r9, {X64::rdi, -1, 32});
+
+            for (const auto &ins : bc.code)
+                translate(x, ins, failures);
+
+            x.store({X64::rdi, -1, 24}, X64::r8);
+            x.store({X64::rdi, -1, 32}, X64::r9);
+            x.return_status(0);
+
+            for (auto at : failures)
+                x.land(at);
+            x.store({X64::rdi, -1, 24}, X64::r8);
+            x.store({X64::rdi, -1, 32}, X64::r9);
+            x.return_status(1);
+
+            length = x.bytes.size();
+            void *p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+                return;
+
+            std::memcpy(p, x.bytes.data(), length);
+            if (mprotect(p, length, PROT_READ | PROT_EXEC) != 0) {
+                munmap(p, length);
+                return;
+            }
+
+            buffer = p;
+            entry = reinterpret_cast<entry_t>(p);
+        }
+#endif
+
+    public:
+        NativeCode(const NativeCode &) = delete;
+
+        NativeCode &operator=(const NativeCode &) = delete;
+
+        ~NativeCode() {
+#ifdef OOASM_JIT_AVAILABLE
+            if (buffer != nullptr)
+                munmap(buffer, length);
+#endif
+        }
+
+        // Translates linked and bound code. Returns null where the JIT is unavailable.
+        static std::unique_ptr<NativeCode> compile(const BytecodeView &bc) {
+#ifdef OOASM_JIT_AVAILABLE
+            if (bc.reach.size() != bc.code.size())
+                return nullptr;
+
+            std::unique_ptr<NativeCode> code(new NativeCode());
+            code->reach = bc.reach.empty() ? 0 : bc.reach.back();
+            for (const auto &ins : bc.code) {
+                if (ins.dst_mode == mode::cell)
+                    code->static_cells.push_back(static_cast<ComputerMemory::vars_size_t>(ins.dst));
+                else
+                    ++code->dynamic_writes;
+            }
+            ComputerMemory::compact(code->static_cells);
+            for (auto c : code->static_cells)
+                code->static_pages.push_back(c >> ComputerMemory::page_shift);
+            code->static_pages.erase(std::unique(code->static_pages.begin(), code->static_pages.end()),
+                                     code->static_pages.end());
+
+            code->assemble(bc);
+            if (code->entry == nullptr)
+                return nullptr;
+            return code;
+#else
+            (void) bc;
+            return nullptr;
+#endif
+        }
+
+        // Runs the code on memory set up by the declarations. Returns false, without
+        // running anything, if the memory is too small for the static addresses.
+        // Throws an error if a dynamic address is out of bounds.
+        bool run(ComputerMemory &cm) const {
+            if (cm.mem.size() < reach)
+                return false;
+
+            cm.dynamic_writes.resize(dynamic_writes);
+            NativeContext context{cm.mem.data(), cm.mem.size(), cm.dynamic_writes.data(), 0, cm.last_result};
+            int status = entry(&context);
+            cm.last_result = context.last_result;
+
+            // Pages of conditional writes are marked even if nothing was written. That only
+            // makes the next setup() zero cells that are zero already.
+            for (auto page : static_pages)
+                cm.mark(page << ComputerMemory::page_shift);
+            if (cm.track_writes) {
+                for (auto c : static_cells)
+                    cm.log(c);
+            }
+            for (std::size_t i = 0; i < context.written; ++i) {
+                cm.mark(cm.dynamic_writes[i]);
+                if (cm.track_writes)
+                    cm.log(cm.dynamic_writes[i]);
+            }
+
+            if (status != 0)
+                throw std::invalid_argument("Out of bounds");
+            return true;
+        }
+    };
+
+    // Native code of a program, compiled the first time it is needed and shared by
+    // copies of the program and by all threads booting it.
+    class NativeProgram {
+    public:
+        static constexpr backend_data slot = backend_data::native;
+
+    private:
+        std::once_flag once;
+        std::unique_ptr<NativeCode> code;
+
+    public:
+        // Returns the native code, or null where the JIT is unavailable.
+        const NativeCode *get(const BytecodeView &bc) {
+            std::call_once(once, [this, &bc] { code = NativeCode::compile(bc); });
+            return code.get();
+        }
+    };
+
+    // Executes linked code on memory set up by the declarations, natively if the backend
+    // is the JIT and the code can run natively, and by the interpreter otherwise.
+    inline void execute(const BytecodeView &bc, NativeProgram &native, ComputerMemory &cm, Backend backend) {
+        if (backend != Backend::jit) {
+            Interpreter(bc, cm).execute();
+            return;
+        }
+
+        const NativeCode *code = native.get(bc);
+#ifdef OOASM_JIT_VERIFY
+        ComputerMemory expected = cm;
+        bool expected_failure = false;
+        try {
+            Interpreter(bc, expected).execute();
+        } catch (std::exception &e) {
+            expected_failure = true;
+        }
+
+        std::exception_ptr failure;
+        try {
+            if (code == nullptr || !code->run(cm))
+                Interpreter(bc, cm).execute();
+        } catch (std::exception &e) {
+            failure = std::current_exception();
+        }
+
+        if ((failure != nullptr) != expected_failure || cm.last_result != expected.last_result ||
+            !std::equal(cm.mem.begin(), cm.mem.end(), expected.mem.begin())) {
+            std::fputs("JIT and interpreter disagree\n", stderr);
+            std::abort();
+        }
+        if (failure)
+            std::rethrow_exception(failure);
+#else
+        if (code == nullptr || !code->run(cm))
+            Interpreter(bc, cm).execute();
+#endif
+    }
+}
+
+#endif //OOASM_JIT_H
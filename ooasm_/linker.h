@@ -0,0 +1,142 @@
+#ifndef OOASM_LINKER_H
+#define OOASM_LINKER_H
+
+// Resolution of identifiers used by lea() to addresses of memory cells.
+#include "bytecode.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace ooasm {
+    class Linker {
+    private:
+        // Rewrites an operand referring to an identifier so it refers to the identifier's
+        // address instead. Returns false if the identifier was never declared.
+        static bool resolve(const std::vector<memory_word_t> &address, mode &m, memory_word_t &operand) {
+            mode resolved;
+            switch (m) {
+                case mode::sym:
+                    resolved = mode::imm;
+                    break;
+                case mode::sym_cell:
+                    resolved = mode::cell;
+                    break;
+                case mode::sym_indirect:
+                    resolved = mode::indirect;
+                    break;
+                default:
+                    return true;
+            }
+
+            memory_word_t a = address[static_cast<size_t>(operand)];
+            if (a < 0)
+                return false;
+
+            m = resolved;
+            operand = a;
+            return true;
+        }
+
+        // Size of memory needed by a static address of linked code, if the operand has one.
+        static uint64_t extent(mode m, memory_word_t operand) noexcept {
+            if (m != mode::cell && m != mode::indirect)
+                return 0;
+
+            auto a = static_cast<uint64_t>(operand);
+            return a == std::numeric_limits<uint64_t>::max() ? a : a + 1;
+        }
+
+    public:
+        // Resolves every lea() of the program once, when it is loaded. Variables are placed
+        // in memory one after another in order of declaration and an identifier declared
+        // many times keeps the cell of its first declaration, so addresses follow from
+        // the declarations alone.
+        static void resolve(Bytecode &bc) {
+            std::vector<memory_word_t> address(bc.symbols.size(), -1);
+            memory_word_t next = 0;
+            for (const auto &d : bc.declarations) {
+                if (address[d.symbol] < 0)
+                    address[d.symbol] = next;
+                ++next;
+            }
+
+            resolve(bc, address);
+        }
+
+        // Resolves every lea() of the code with the given [address] of each identifier,
+        // negative for identifiers that were never declared.
+        static void resolve(Bytecode &bc, const std::vector<memory_word_t> &address) {
+            for (auto &ins : bc.code) {
+                if (!resolve(address, ins.dst_mode, ins.dst) || !resolve(address, ins.src_mode, ins.src))
+                    bc.unresolved = true;
+            }
+        }
+
+        // Resolves every lea() of the code with the addresses memory gave the identifiers
+        // declared so far, [vars] being null if none were.
+        static void resolve(Bytecode &bc, const ComputerMemory::vars_memory_t *vars) {
+            std::vector<memory_word_t> address(bc.symbols.size(), -1);
+            for (std::size_t i = 0; vars != nullptr && i < bc.symbols.size(); ++i) {
+                auto it = vars->find(bc.symbols[i]);
+                if (it != vars->end())
+                    address[i] = static_cast<memory_word_t>(it->second);
+            }
+
+            resolve(bc, address);
+        }
+
+        // Returns the address of every identifier the code declares, that of its first
+        // declaration, for memory to name its cells by. [name] returns the identifier
+        // with a given index.
+        template<typename Name>
+        static std::shared_ptr<ComputerMemory::vars_memory_t> addresses(const BytecodeView &bc, Name &&name) {
+            auto vars = std::make_shared<ComputerMemory::vars_memory_t>();
+            vars->reserve(bc.declarations.size());
+            for (std::size_t i = 0; i < bc.declarations.size(); ++i)
+                vars->emplace(name(bc.declarations[i].symbol), i);
+            return vars;
+        }
+
+        static std::shared_ptr<ComputerMemory::vars_memory_t> addresses(const Bytecode &bc) {
+            return addresses(bc, [&](uint32_t symbol) -> const identifier_t & { return bc.symbols[symbol]; });
+        }
+
+        // Binds static addresses of linked code once the code is final. Whether a static
+        // address fits in memory depends only on the memory's size, so instead of checking
+        // it on every access, the code is split where the first one does not fit.
+        static void bind(Bytecode &bc) {
+            bc.reach.clear();
+            bc.reach.reserve(bc.code.size());
+
+            uint64_t r = 0;
+            for (const auto &ins : bc.code) {
+                r = reach(r, ins);
+                bc.reach.push_back(r);
+            }
+        }
+
+        // Reach of an instruction following code of reach [previous], see Bytecode.
+        static uint64_t reach(uint64_t previous, const Instruction &ins) noexcept {
+            return std::max({previous, extent(ins.dst_mode, ins.dst), extent(ins.src_mode, ins.src)});
+        }
+
+        // Returns how many instructions from the start of bound code have all static
+        // addresses within a memory of [size] cells.
+        static std::size_t bound(const BytecodeView &bc, uint64_t size) {
+            return static_cast<std::size_t>(std::upper_bound(bc.reach.begin(), bc.reach.end(), size) - bc.reach.begin());
+        }
+
+        // Link step run after all declarations. Throws an error if the program
+        // refers to an identifier that was never declared.
+        static void check(const BytecodeView &bc) {
+            if (bc.unresolved)
+                throw std::invalid_argument("Variable not found");
+        }
+    };
+}
+
+#endif //OOASM_LINKER_H
@@ -0,0 +1,273 @@
+#ifndef OOASM_MEMORY_IMAGE_H
+#define OOASM_MEMORY_IMAGE_H
+
+// Text and binary dumps of the computer's memory.
+//
+// The binary image is a 16-byte header followed by the cells as little-endian
+// 64-bit signed integers, so the cells of a mapped image are 8-byte aligned:
+//   offset 0: magic "OOASMEM1"
+//   offset 8: number of cells, little-endian unsigned 64-bit integer
+//
+// A delta lists cells changed since the previous delta, all integers little-endian:
+//   offset 0:  magic "OOASMDL1"
+//   offset 8:  number of cells of the memory, unsigned 64-bit
+//   offset 16: 1 if the image has to be zeroed before applying, 0 otherwise, unsigned 64-bit
+//   offset 24: number of changes, unsigned 64-bit
+//   offset 32: changes as pairs of address (unsigned 64-bit) and value (signed 64-bit)
+#include "computer_memory.h"
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ooasm {
+    enum class dump_format {
+        text, binary
+    };
+
+    namespace image {
+        constexpr char magic[8] = {'O', 'O', 'A', 'S', 'M', 'E', 'M', '1'};
+        constexpr char delta_magic[8] = {'O', 'O', 'A', 'S', 'M', 'D', 'L', '1'};
+        constexpr std::size_t header_size = 16;
+
+        inline bool little_endian() noexcept {
+            const uint16_t probe = 1;
+            unsigned char first;
+            std::memcpy(&first, &probe, 1);
+            return first == 1;
+        }
+
+        inline uint64_t to_little_endian(uint64_t value) noexcept {
+            if (little_endian())
+                return value;
+
+            uint64_t swapped = 0;
+            for (int i = 0; i < 8; ++i) {
+                swapped = (swapped << 8) | (value & 0xff);
+                value >>= 8;
+            }
+            return swapped;
+        }
+
+        // Conversion is its own inverse.
+        inline uint64_t from_little_endian(uint64_t value) noexcept {
+            return to_little_endian(value);
+        }
+
+        inline void write_u64(std::ostream &os, uint64_t value) {
+            value = to_little_endian(value);
+            os.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        inline uint64_t read_u64(std::istream &is) {
+            uint64_t value;
+            if (!is.read(reinterpret_cast<char *>(&value), sizeof(value)))
+                throw std::invalid_argument("Truncated memory delta");
+            return from_little_endian(value);
+        }
+    }
+
+    // Cells changed since the previous delta of the same memory. A [full] delta
+    // starts from zeroed memory of [size] cells.
+    struct MemoryDelta {
+        uint64_t size = 0;
+        bool full = false;
+        std::vector<std::pair<uint64_t, memory_word_t>> changes;
+    };
+
+    inline void write_delta(std::ostream &os, const MemoryDelta &delta) {
+        os.write(image::delta_magic, sizeof(image::delta_magic));
+        image::write_u64(os, delta.size);
+        image::write_u64(os, delta.full ? 1 : 0);
+        image::write_u64(os, delta.changes.size());
+        for (const auto &[address, value] : delta.changes) {
+            image::write_u64(os, address);
+            image::write_u64(os, static_cast<uint64_t>(value));
+        }
+    }
+
+    // Reads a delta. Throws an error if the stream does not hold one.
+    inline MemoryDelta read_delta(std::istream &is) {
+        char magic[sizeof(image::delta_magic)];
+        if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, image::delta_magic, sizeof(magic)) != 0)
+            throw std::invalid_argument("Not a memory delta");
+
+        MemoryDelta delta;
+        delta.size = image::read_u64(is);
+        delta.full = image::read_u64(is) != 0;
+        uint64_t count = image::read_u64(is);
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t address = image::read_u64(is);
+            auto value = static_cast<memory_word_t>(image::read_u64(is));
+            if (address >= delta.size)
+                throw std::invalid_argument("Out of bounds");
+            delta.changes.emplace_back(address, value);
+        }
+
+        return delta;
+    }
+
+    // Brings a memory image up to date with a delta. The size comes from the delta, so
+    // deltas of memory larger than [max_size] cells are rejected before allocating it.
+    inline void apply_delta(const MemoryDelta &delta, std::vector<memory_word_t> &cells, uint64_t max_size) {
+        if (delta.size > max_size)
+            throw std::invalid_argument("Memory delta too large");
+
+        if (delta.full || cells.size() != delta.size)
+            cells.assign(delta.size, 0);
+
+        for (const auto &[address, value] : delta.changes)
+            cells[address] = value;
+    }
+
+    // Writes cells as decimal numbers each followed by a space, the same text as
+    // streaming them one by one, but formatted with to_chars into large chunks.
+    template<typename Word>
+    void write_text(std::ostream &os, const Word *begin, const Word *end) {
+        constexpr std::size_t chunk = 1 << 16;
+        constexpr std::size_t word_length = 21; // "-9223372036854775808 "
+        char buffer[chunk];
+        char *out = buffer;
+
+        for (const Word *it = begin; it != end; ++it) {
+            if (buffer + chunk - out < static_cast<std::ptrdiff_t>(word_length)) {
+                os.write(buffer, out - buffer);
+                out = buffer;
+            }
+
+            out = std::to_chars(out, buffer + chunk, *it).ptr;
+            *out++ = ' ';
+        }
+
+        os.write(buffer, out - buffer);
+    }
+
+    // Writes cells as a binary image. Images hold 64-bit words whatever the width of
+    // the cells, so narrower ones are sign-extended.
+    template<typename Word>
+    void write_image(std::ostream &os, const Word *begin, const Word *end) {
+        char header[image::header_size];
+        uint64_t count = image::to_little_endian(static_cast<uint64_t>(end - begin));
+        std::memcpy(header, image::magic, sizeof(image::magic));
+        std::memcpy(header + sizeof(image::magic), &count, sizeof(count));
+        os.write(header, sizeof(header));
+
+        if (std::is_same_v<Word, memory_word_t> && image::little_endian()) {
+            os.write(reinterpret_cast<const char *>(begin),
+                     static_cast<std::streamsize>((end - begin) * sizeof(memory_word_t)));
+            return;
+        }
+
+        constexpr std::size_t chunk = 1 << 12;
+        uint64_t buffer[chunk];
+        while (begin != end) {
+            std::size_t n = std::min<std::size_t>(chunk, static_cast<std::size_t>(end - begin));
+            for (std::size_t i = 0; i < n; ++i)
+                buffer[i] = image::to_little_endian(static_cast<uint64_t>(static_cast<memory_word_t>(begin[i])));
+            os.write(reinterpret_cast<const char *>(buffer), static_cast<std::streamsize>(n * sizeof(uint64_t)));
+            begin += n;
+        }
+    }
+
+    // Reads cells of a binary image. Throws an error if the stream does not hold one.
+    inline std::vector<memory_word_t> read_image(std::istream &is) {
+        char header[image::header_size];
+        if (!is.read(header, sizeof(header)) || std::memcmp(header, image::magic, sizeof(image::magic)) != 0)
+            throw std::invalid_argument("Not a memory image");
+
+        uint64_t count;
+        std::memcpy(&count, header + sizeof(image::magic), sizeof(count));
+        count = image::from_little_endian(count);
+
+        // The count comes from the stream, so cells are read in chunks and memory grows
+        // only with what the stream actually holds.
+        constexpr uint64_t chunk = 1 << 16;
+        std::vector<memory_word_t> cells;
+        while (cells.size() < count) {
+            std::size_t from = cells.size();
+            auto n = static_cast<std::size_t>(std::min<uint64_t>(chunk, count - from));
+            cells.resize(from + n);
+            if (!is.read(reinterpret_cast<char *>(cells.data() + from),
+                         static_cast<std::streamsize>(n * sizeof(memory_word_t))))
+                throw std::invalid_argument("Truncated memory image");
+        }
+
+        if (!image::little_endian()) {
+            for (auto &cell : cells)
+                cell = static_cast<memory_word_t>(image::from_little_endian(static_cast<uint64_t>(cell)));
+        }
+
+        return cells;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    // Binary image file mapped into memory. Cells are read in place, without copying,
+    // on little-endian machines.
+    class MappedImage {
+    private:
+        void *base = MAP_FAILED;
+        std::size_t length = 0;
+
+    public:
+        explicit MappedImage(const std::string &path) {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Cannot open memory image");
+
+            struct stat st{};
+            if (fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= image::header_size) {
+                length = static_cast<std::size_t>(st.st_size);
+                base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+            close(fd);
+
+            if (base == MAP_FAILED)
+                throw std::runtime_error("Cannot map memory image");
+            if (!image::little_endian() || std::memcmp(base, image::magic, sizeof(image::magic)) != 0 ||
+                size() > (length - image::header_size) / sizeof(memory_word_t)) {
+                munmap(base, length);
+                throw std::invalid_argument("Not a memory image");
+            }
+        }
+
+        MappedImage(const MappedImage &) = delete;
+
+        MappedImage &operator=(const MappedImage &) = delete;
+
+        ~MappedImage() {
+            munmap(base, length);
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            uint64_t count;
+            std::memcpy(&count, static_cast<const char *>(base) + sizeof(image::magic), sizeof(count));
+            return static_cast<std::size_t>(count);
+        }
+
+        [[nodiscard]] const memory_word_t *begin() const noexcept {
+            return reinterpret_cast<const memory_word_t *>(static_cast<const char *>(base) + image::header_size);
+        }
+
+        [[nodiscard]] const memory_word_t *end() const noexcept {
+            return begin() + size();
+        }
+    };
+#endif
+}
+
+#endif //OOASM_MEMORY_IMAGE_H
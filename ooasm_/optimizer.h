@@ -0,0 +1,328 @@
+#ifndef OOASM_OPTIMIZER_H
+#define OOASM_OPTIMIZER_H
+
+// Optimization of linked bytecode, run once when the program is loaded.
+#include "bytecode.h"
+#include "computer_memory.h"
+#include "linker.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ooasm {
+    // Rewrites linked code into shorter code with exactly the same effect on memory and
+    // on flags read by ones() and onez(), including the memory left behind when an
+    // instruction goes out of bounds.
+    //
+    // The size of the memory is not known yet, so every rewrite relies on what a successful
+    // run proves about it: all declarations fit, and a static address that was accessed once
+    // is in bounds from then on, so are all addresses below it. Values of declared cells are
+    // never assumed, because BatchComputer replaces them for every lane. Code for words
+    // narrower than 64 bits decides flags and addresses from known values only while they
+    // fit in those words, which wrap around where 64-bit words do not.
+    class Optimizer {
+    private:
+        using address_t = uint64_t;
+
+        static bool has_src(opcode op) noexcept {
+            return op == opcode::mov || op == opcode::add || op == opcode::sub;
+        }
+
+        static bool arithmetic(opcode op) noexcept {
+            return op == opcode::add || op == opcode::sub;
+        }
+
+        static bool conditional(opcode op) noexcept {
+            return op == opcode::ones || op == opcode::onez;
+        }
+
+        static address_t address(memory_word_t operand) noexcept {
+            return static_cast<address_t>(operand);
+        }
+
+        // Tells whether words of [bits] bits hold the value as it is.
+        static bool fits(memory_word_t value, unsigned bits) noexcept {
+            if (bits >= 64)
+                return true;
+            memory_word_t limit = memory_word_t(1) << (bits - 1);
+            return value >= -limit && value < limit;
+        }
+
+        static memory_word_t wrapping_add(memory_word_t a, memory_word_t b) noexcept {
+            return static_cast<memory_word_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+        }
+
+        // Raises [bound] past a static address known to be accessed.
+        static void access(mode m, memory_word_t operand, address_t &bound) noexcept {
+            if (m == mode::cell || m == mode::indirect)
+                bound = std::max(bound, address(operand) + 1);
+        }
+
+        // Raises [bound] past every static address the instruction surely accesses when it
+        // completes. A conditional write may leave its operand alone.
+        static void prove(const Instruction &ins, address_t &bound) noexcept {
+            if (has_src(ins.op))
+                access(ins.src_mode, ins.src, bound);
+            if (!conditional(ins.op))
+                access(ins.dst_mode, ins.dst, bound);
+        }
+
+        // Tells whether the instruction completes whatever the size of the memory.
+        static bool safe(const Instruction &ins, address_t bound) noexcept {
+            if (ins.dst_mode != mode::cell || address(ins.dst) >= bound)
+                return false;
+
+            return !has_src(ins.op) || ins.src_mode == mode::imm ||
+                   (ins.src_mode == mode::cell && address(ins.src) < bound);
+        }
+
+        // What is known about memory and flags at some point of the code. Every cell in
+        // [values] is in bounds. Cells past the declarations that nothing wrote yet are zero.
+        struct State {
+            unsigned bits;
+            address_t declared;
+            address_t bound;
+            std::unordered_map<address_t, memory_word_t> values;
+            std::unordered_set<address_t> written;
+            bool clobbered = false;
+            std::optional<bool> ZF = false;
+            std::optional<bool> SF = false;
+
+            State(unsigned _bits, address_t _declared) : bits(_bits), declared(_declared), bound(_declared) {}
+
+            [[nodiscard]] std::optional<memory_word_t> lookup(address_t a) const {
+                auto it = values.find(a);
+                if (it != values.end())
+                    return it->second;
+                if (a >= declared && a < bound && !clobbered && written.count(a) == 0)
+                    return 0;
+                return std::nullopt;
+            }
+
+            void store(address_t a, std::optional<memory_word_t> value) {
+                written.insert(a);
+                if (value && a < bound)
+                    values[a] = *value;
+                else
+                    values.erase(a);
+            }
+
+            void clobber() {
+                values.clear();
+                clobbered = true;
+            }
+        };
+
+        // Replaces reads of cells with known values: an r-value becomes a literal,
+        // and an indirect operand loses the references that are known.
+        static void fold(const State &state, mode &m, memory_word_t &operand, uint32_t &depth, bool rvalue) {
+            while (m == mode::indirect) {
+                auto known = state.lookup(address(operand));
+                if (!known || !fits(*known, state.bits))
+                    return;
+
+                operand = *known;
+                if (--depth == 1)
+                    m = mode::cell;
+            }
+
+            if (rvalue && m == mode::cell) {
+                if (auto known = state.lookup(address(operand))) {
+                    m = mode::imm;
+                    operand = *known;
+                    depth = 0;
+                }
+            }
+        }
+
+        // Forward pass propagating known values of cells and flags. Folds operands,
+        // resolves conditional writes whose flag is known and drops writes of a value
+        // the cell already holds.
+        static void propagate(Bytecode &bc, unsigned bits) {
+            State state(bits, bc.declarations.size());
+            std::vector<Instruction> out;
+            out.reserve(bc.code.size());
+
+            for (Instruction ins : bc.code) {
+                if (has_src(ins.op))
+                    fold(state, ins.src_mode, ins.src, ins.src_depth, true);
+                fold(state, ins.dst_mode, ins.dst, ins.dst_depth, false);
+
+                bool is_cell = ins.dst_mode == mode::cell;
+                std::optional<memory_word_t> before = is_cell ? state.lookup(address(ins.dst)) : std::nullopt;
+                std::optional<memory_word_t> after;
+
+                if (conditional(ins.op)) {
+                    std::optional<bool> flag = ins.op == opcode::ones ? state.SF : state.ZF;
+                    if (flag && !*flag)
+                        continue;
+                    if (flag)
+                        ins.op = opcode::one;
+                }
+
+                switch (ins.op) {
+                    case opcode::mov:
+                        if (ins.src_mode == mode::imm)
+                            after = ins.src;
+                        break;
+                    case opcode::one:
+                        after = 1;
+                        break;
+                    case opcode::add:
+                    case opcode::sub:
+                        if (before && ins.src_mode == mode::imm) {
+                            memory_word_t s = ins.op == opcode::sub ? wrapping_add(~ins.src, 1) : ins.src;
+                            after = wrapping_add(*before, s);
+                        }
+                        if (after && fits(*after, bits)) {
+                            state.ZF = *after == 0;
+                            state.SF = *after < 0;
+                        } else {
+                            state.ZF.reset();
+                            state.SF.reset();
+                        }
+                        break;
+                    case opcode::ones:
+                    case opcode::onez:
+                        if (before == 1)
+                            after = 1;
+                        break;
+                }
+
+                // Writing a value the cell already holds changes nothing and cannot fail.
+                if (!arithmetic(ins.op) && before && after == before && safe(ins, state.bound))
+                    continue;
+
+                prove(ins, state.bound);
+                if (is_cell)
+                    state.store(address(ins.dst), after);
+                else
+                    state.clobber();
+
+                out.push_back(ins);
+            }
+
+            bc.code = std::move(out);
+        }
+
+        // Merges runs of additions and subtractions of literals to the same static cell.
+        // The merged instruction fails where the first of the run did, and leaves the
+        // value and the flags the last one did.
+        static void merge(Bytecode &bc) {
+            std::vector<Instruction> out;
+            out.reserve(bc.code.size());
+
+            auto mergeable = [](const Instruction &ins) {
+                return arithmetic(ins.op) && ins.dst_mode == mode::cell && ins.src_mode == mode::imm;
+            };
+
+            for (const Instruction &ins : bc.code) {
+                if (mergeable(ins) && !out.empty() && mergeable(out.back()) && out.back().dst == ins.dst) {
+                    Instruction &run = out.back();
+                    if (run.op == opcode::sub) {
+                        run.op = opcode::add;
+                        run.src = wrapping_add(~run.src, 1);
+                    }
+                    run.src = wrapping_add(run.src, ins.op == opcode::sub ? wrapping_add(~ins.src, 1) : ins.src);
+                    continue;
+                }
+
+                out.push_back(ins);
+            }
+
+            bc.code = std::move(out);
+        }
+
+        // Removes writes overwritten before anything reads them. Only stretches of code
+        // that cannot fail are considered, so a failure never shows a skipped write.
+        static void eliminate_dead_stores(Bytecode &bc) {
+            address_t bound = bc.declarations.size();
+            std::unordered_map<address_t, std::size_t> pending;
+            std::vector<bool> dead(bc.code.size(), false);
+
+            for (std::size_t i = 0; i < bc.code.size(); ++i) {
+                const Instruction &ins = bc.code[i];
+
+                if (!safe(ins, bound)) {
+                    pending.clear();
+                } else {
+                    if (has_src(ins.op) && ins.src_mode == mode::cell)
+                        pending.erase(address(ins.src));
+                    if (arithmetic(ins.op))
+                        pending.erase(address(ins.dst));
+
+                    if (ins.op == opcode::mov || ins.op == opcode::one) {
+                        auto it = pending.find(address(ins.dst));
+                        if (it != pending.end())
+                            dead[it->second] = true;
+                        pending[address(ins.dst)] = i;
+                    }
+                }
+
+                prove(ins, bound);
+            }
+
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < bc.code.size(); ++i) {
+                if (!dead[i])
+                    bc.code[kept++] = bc.code[i];
+            }
+            bc.code.resize(kept);
+        }
+
+        // Clears [sets_flags] of arithmetic whose flags are replaced before ones() or onez()
+        // reads them. Flags left at the end are part of the result, programs resumed from
+        // it read them (see Computer::resume()).
+        static void drop_dead_flags(Bytecode &bc) {
+            bool live = true;
+            for (auto it = bc.code.rbegin(); it != bc.code.rend(); ++it) {
+                if (conditional(it->op)) {
+                    live = true;
+                } else if (arithmetic(it->op)) {
+                    it->sets_flags = live;
+                    live = false;
+                }
+            }
+        }
+
+    public:
+        // Optimizes linked code in place, for words of [bits] bits. Code referring to
+        // undeclared identifiers never runs and is left alone.
+        static void optimize(Bytecode &bc, unsigned bits = 64) {
+            if (bc.unresolved)
+                return;
+
+            propagate(bc, bits);
+            merge(bc);
+            eliminate_dead_stores(bc);
+            drop_dead_flags(bc);
+        }
+    };
+
+    // Code of a program optimized and bound for words of 16 or 32 bits, made on first use.
+    class NarrowProgram {
+    private:
+        std::once_flag once[2];
+        Bytecode code[2];
+
+    public:
+        // Optimizes [lowered], the program as lowered, the first time [bits] is asked for.
+        template<typename Lower>
+        const Bytecode &get(unsigned bits, Lower lowered) {
+            std::size_t i = bits == 16 ? 0 : 1;
+            std::call_once(once[i], [&] {
+                code[i] = lowered();
+                Optimizer::optimize(code[i], bits);
+                Linker::bind(code[i]);
+            });
+            return code[i];
+        }
+    };
+}
+
+#endif //OOASM_OPTIMIZER_H
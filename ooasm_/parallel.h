@@ -0,0 +1,352 @@
+#ifndef OOASM_PARALLEL_H
+#define OOASM_PARALLEL_H
+
+// Execution of independent chains of instructions on several threads.
+#include "backend_cache.h"
+#include "bytecode.h"
+#include "computer_memory.h"
+#include "interpreter.h"
+#include "linker.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ooasm {
+    // Dependency graph of linked, bound code. Without jumps, an instruction depends only
+    // on earlier instructions touching the same cells and, for ones() and onez(), on the
+    // last arithmetic setting flags. Cells of static addresses are known before the code
+    // runs, so the code is cut at every instruction with a dynamic address, which stays
+    // a barrier run alone, and every long enough run of static instructions in between
+    // falls into chains sharing no cell, which may run at the same time.
+    class Schedule {
+    public:
+        static constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+        // Instructions [begin, end) split into chains. Chain [g] is the instructions
+        // code[starts[g]] to code[starts[g + 1] - 1], in the order of the program, and
+        // chains are copied one after the other so each runs through contiguous code.
+        struct Segment {
+            std::size_t begin;
+            std::size_t end;
+            std::vector<Instruction> code;
+            std::vector<std::size_t> starts;
+            // Chain holding the last instruction of the segment that sets flags.
+            std::size_t flags_chain = none;
+            // Pages and cells the segment may write, marked before it runs.
+            std::vector<ComputerMemory::vars_size_t> pages;
+            std::vector<ComputerMemory::vars_size_t> cells;
+        };
+
+        std::vector<Segment> segments;
+
+        static bool is_static(mode m) noexcept {
+            return m == mode::imm || m == mode::cell;
+        }
+
+        static bool is_static(const Instruction &ins) noexcept {
+            return is_static(ins.dst_mode) && is_static(ins.src_mode);
+        }
+
+    private:
+        static std::size_t find(std::vector<std::size_t> &parent, std::size_t i) {
+            while (parent[i] != i)
+                i = parent[i] = parent[parent[i]];
+            return i;
+        }
+
+        static void join(std::vector<std::size_t> &parent, std::size_t a, std::size_t b) {
+            a = find(parent, a);
+            b = find(parent, b);
+            if (a != b)
+                parent[std::max(a, b)] = std::min(a, b);
+        }
+
+        // Splits static instructions [begin, end) into chains with union-find. Returns
+        // false if they form a single chain.
+        static bool split(const BytecodeView &bc, Segment &s) {
+            std::size_t n = s.end - s.begin;
+            std::vector<std::size_t> parent(n);
+            std::iota(parent.begin(), parent.end(), 0);
+
+            std::unordered_map<memory_word_t, std::size_t> last_access;
+            std::size_t last_flags = none;
+            std::vector<ComputerMemory::vars_size_t> written;
+            auto touch = [&](std::size_t i, mode m, memory_word_t operand) {
+                if (m != mode::cell)
+                    return;
+                auto [it, inserted] = last_access.try_emplace(operand, i);
+                if (!inserted) {
+                    join(parent, it->second, i);
+                    it->second = i;
+                }
+            };
+
+            for (std::size_t i = 0; i < n; ++i) {
+                const Instruction &ins = bc.code[s.begin + i];
+                touch(i, ins.dst_mode, ins.dst);
+                written.push_back(static_cast<ComputerMemory::vars_size_t>(ins.dst));
+                if (ins.op == opcode::mov || ins.op == opcode::add || ins.op == opcode::sub)
+                    touch(i, ins.src_mode, ins.src);
+                if (ins.op == opcode::ones || ins.op == opcode::onez) {
+                    if (last_flags != none)
+                        join(parent, last_flags, i);
+                }
+                if ((ins.op == opcode::add || ins.op == opcode::sub) && ins.sets_flags)
+                    last_flags = i;
+            }
+
+            // Chains are numbered by their first instruction.
+            std::vector<std::size_t> chain(n, none), size;
+            for (std::size_t i = 0; i < n; ++i) {
+                std::size_t root = find(parent, i);
+                if (chain[root] == none) {
+                    chain[root] = size.size();
+                    size.push_back(0);
+                }
+                chain[i] = chain[root];
+                ++size[chain[i]];
+            }
+            if (size.size() < 2)
+                return false;
+
+            s.starts.assign(size.size() + 1, 0);
+            for (std::size_t g = 0; g < size.size(); ++g)
+                s.starts[g + 1] = s.starts[g] + size[g];
+            s.code.resize(n);
+            std::vector<std::size_t> next(s.starts.begin(), s.starts.end() - 1);
+            for (std::size_t i = 0; i < n; ++i)
+                s.code[next[chain[i]]++] = bc.code[s.begin + i];
+            if (last_flags != none)
+                s.flags_chain = chain[last_flags];
+
+            ComputerMemory::compact(written);
+            s.cells = std::move(written);
+            for (auto cell : s.cells) {
+                auto page = cell >> ComputerMemory::page_shift;
+                if (s.pages.empty() || s.pages.back() != page)
+                    s.pages.push_back(page);
+            }
+            return true;
+        }
+
+    public:
+        // Makes the schedule of bound code, with segments of at least [min_segment]
+        // instructions. Code that is not bound gets no segments.
+        static Schedule build(const BytecodeView &bc, std::size_t min_segment = 1024) {
+            Schedule schedule;
+            if (bc.reach.size() != bc.code.size())
+                return schedule;
+
+            std::size_t i = 0;
+            while (i < bc.code.size()) {
+                if (!is_static(bc.code[i])) {
+                    ++i;
+                    continue;
+                }
+
+                Segment s;
+                s.begin = i;
+                while (i < bc.code.size() && is_static(bc.code[i]))
+                    ++i;
+                s.end = i;
+                if (s.end - s.begin >= std::max<std::size_t>(min_segment, 2) && split(bc, s))
+                    schedule.segments.push_back(std::move(s));
+            }
+            return schedule;
+        }
+    };
+
+    // Schedule of a program, made the first time it is needed and shared by copies of
+    // the program and by all threads booting it.
+    class ScheduledProgram {
+    public:
+        static constexpr backend_data slot = backend_data::schedule;
+
+    private:
+        std::once_flag once;
+        Schedule schedule;
+
+    public:
+        const Schedule &get(const BytecodeView &bc) {
+            std::call_once(once, [this, &bc] { schedule = Schedule::build(bc); });
+            return schedule;
+        }
+    };
+
+    // Runs code on a pool of threads following its schedule. Segments whose static
+    // addresses all fit in memory run their chains on all threads, each thread taking
+    // a contiguous share of the chains; such segments cannot fail, so memory is left as
+    // if the code ran in order. Everything else runs on the calling thread through the
+    // interpreter, with all of its checks.
+    class ParallelExecutor {
+    private:
+        std::vector<std::thread> threads;
+        std::mutex lock;
+        std::condition_variable wake, finished;
+        uint64_t generation = 0;
+        std::size_t pending = 0;
+        bool stopping = false;
+
+        // Segment being run.
+        const Schedule::Segment *segment = nullptr;
+        memory_word_t *mem = nullptr;
+        memory_word_t initial_result = 0;
+        memory_word_t final_result = 0;
+
+        static memory_word_t operand(const memory_word_t *cells, mode m, memory_word_t value) noexcept {
+            return m == mode::imm ? value : cells[value];
+        }
+
+        // Runs chains [first, last) of the segment on memory known to hold them.
+        void run_chains(std::size_t first, std::size_t last) {
+            const auto &s = *segment;
+            for (std::size_t g = first; g < last; ++g) {
+                memory_word_t result = initial_result;
+                for (std::size_t k = s.starts[g]; k < s.starts[g + 1]; ++k) {
+                    const Instruction &ins = s.code[k];
+                    memory_word_t &dst = mem[ins.dst];
+                    switch (ins.op) {
+                        case opcode::mov:
+                            dst = operand(mem, ins.src_mode, ins.src);
+                            break;
+                        case opcode::add:
+                            dst = static_cast<memory_word_t>(static_cast<uint64_t>(dst) +
+                                                             static_cast<uint64_t>(operand(mem, ins.src_mode, ins.src)));
+                            if (ins.sets_flags)
+                                result = dst;
+                            break;
+                        case opcode::sub:
+                            dst = static_cast<memory_word_t>(static_cast<uint64_t>(dst) -
+                                                             static_cast<uint64_t>(operand(mem, ins.src_mode, ins.src)));
+                            if (ins.sets_flags)
+                                result = dst;
+                            break;
+                        case opcode::one:
+                            dst = 1;
+                            break;
+                        case opcode::ones:
+                            if (result < 0)
+                                dst = 1;
+                            break;
+                        case opcode::onez:
+                            if (result == 0)
+                                dst = 1;
+                            break;
+                    }
+                }
+                if (g == s.flags_chain)
+                    final_result = result;
+            }
+        }
+
+        // Runs the share of chains of worker [k], balanced by instructions.
+        void run_share(std::size_t k) {
+            const auto &starts = segment->starts;
+            std::size_t workers = threads.size() + 1;
+            std::size_t total = starts.back();
+            auto chain_at = [&](std::size_t w) {
+                std::size_t offset = total / workers * w + std::min(w, total % workers);
+                return static_cast<std::size_t>(std::lower_bound(starts.begin(), starts.end() - 1, offset) -
+                                                starts.begin());
+            };
+            run_chains(chain_at(k), chain_at(k + 1));
+        }
+
+        void work(std::size_t k) {
+            uint64_t seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    wake.wait(guard, [&] { return stopping || generation != seen; });
+                    if (stopping)
+                        return;
+                    seen = generation;
+                }
+                run_share(k);
+                std::lock_guard<std::mutex> guard(lock);
+                if (--pending == 0)
+                    finished.notify_one();
+            }
+        }
+
+        void run_segment(const Schedule::Segment &s, ComputerMemory &cm) {
+            for (auto page : s.pages)
+                cm.mark(page << ComputerMemory::page_shift);
+            if (cm.track_writes) {
+                for (auto cell : s.cells)
+                    cm.log(cell);
+            }
+
+            segment = &s;
+            mem = cm.mem.data();
+            initial_result = cm.last_result;
+            final_result = cm.last_result;
+            if (!threads.empty()) {
+                std::lock_guard<std::mutex> guard(lock);
+                pending = threads.size();
+                ++generation;
+            }
+            wake.notify_all();
+
+            run_share(0);
+            if (!threads.empty()) {
+                std::unique_lock<std::mutex> guard(lock);
+                finished.wait(guard, [&] { return pending == 0; });
+            }
+            cm.last_result = final_result;
+        }
+
+    public:
+        // Starts [workers] - 1 threads, the calling thread being the last worker.
+        // Zero means one worker per core.
+        explicit ParallelExecutor(std::size_t workers = 0) {
+            if (workers == 0)
+                workers = std::max(1u, std::thread::hardware_concurrency());
+            for (std::size_t k = 1; k < workers; ++k)
+                threads.emplace_back([this, k] { work(k); });
+        }
+
+        ParallelExecutor(const ParallelExecutor &) = delete;
+
+        ParallelExecutor &operator=(const ParallelExecutor &) = delete;
+
+        ~ParallelExecutor() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto &t : threads)
+                t.join();
+        }
+
+        [[nodiscard]] std::size_t workers() const noexcept {
+            return threads.size() + 1;
+        }
+
+        // Executes linked code on memory set up by the declarations.
+        void execute(const BytecodeView &bc, const Schedule &schedule, ComputerMemory &cm) {
+            Interpreter interpreter(bc, cm);
+            std::size_t done = 0;
+            for (const auto &s : schedule.segments) {
+                interpreter.execute(done, s.begin);
+                if (bc.reach[s.end - 1] <= cm.mem.size())
+                    run_segment(s, cm);
+                else
+                    interpreter.execute(s.begin, s.end);
+                done = s.end;
+            }
+            interpreter.execute(done, bc.code.size());
+        }
+    };
+}
+
+#endif //OOASM_PARALLEL_H
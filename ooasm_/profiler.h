@@ -0,0 +1,180 @@
+#ifndef OOASM_PROFILER_H
+#define OOASM_PROFILER_H
+
+// Profiles of boots: how often every kind of function runs, how often every cell is
+// read and written, and where the time goes.
+#include "bytecode.h"
+#include "computer_memory.h"
+#include "interpreter.h"
+#include "linker.h"
+#include "ooasm.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ooasm {
+    // Observer of the interpreter collecting the profile of one program over any number
+    // of boots, see Computer::boot(Profiler &). Ordinary boots are not observed and pay
+    // nothing for it.
+    //
+    // Profiled boots interpret the program as lowered, neither optimized nor compiled,
+    // so every instruction is one function of the program and counts refer to what the
+    // program says. Time is attributed to regions of [region_size] consecutive
+    // instructions with one clock reading per region, and to declarations.
+    class Profiler {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        struct Cell {
+            uint64_t reads = 0;
+            uint64_t writes = 0;
+        };
+
+        // Functions [first, last) of the program, by position, and the time spent in them.
+        struct Region {
+            std::size_t first;
+            std::size_t last;
+            double seconds;
+        };
+
+        static constexpr const char *names[element_count] = {
+                "data", "mov", "add", "sub", "inc", "dec", "one", "ones", "onez"
+        };
+
+    private:
+        static constexpr std::size_t declaring = std::numeric_limits<std::size_t>::max();
+
+        Bytecode bc;
+        std::vector<element> kinds;
+        std::vector<std::size_t> positions;
+        std::size_t region_size;
+
+        std::array<uint64_t, element_count> executed{};
+        std::unordered_map<ComputerMemory::vars_size_t, Cell> heat;
+        std::vector<double> region_seconds;
+        double declaration_seconds = 0;
+
+        clock::time_point lap_start;
+        std::size_t current = declaring;
+        std::size_t next_lap = 0;
+
+        // Charges the time since the last lap to the current region and starts timing [next].
+        void lap(std::size_t next) {
+            auto now = clock::now();
+            double elapsed = std::chrono::duration<double>(now - lap_start).count();
+            if (current == declaring)
+                declaration_seconds += elapsed;
+            else
+                region_seconds[current] += elapsed;
+            current = next;
+            lap_start = now;
+        }
+
+    public:
+        explicit Profiler(program &p, std::size_t _region_size = 1024)
+                : bc(p.lower()), positions(p.positions()), region_size(std::max<std::size_t>(_region_size, 1)) {
+            Linker::bind(bc);
+
+            for (auto position : positions)
+                kinds.push_back(p.begin()[static_cast<std::ptrdiff_t>(position)]->kind());
+            region_seconds.assign((bc.code.size() + region_size - 1) / region_size, 0);
+        }
+
+        [[nodiscard]] const Bytecode &bytecode() const noexcept {
+            return bc;
+        }
+
+        // Starts and stops timing a boot.
+        void start() {
+            current = declaring;
+            next_lap = 0;
+            lap_start = clock::now();
+        }
+
+        void stop() {
+            lap(declaring);
+        }
+
+        // Observer of the interpreter.
+        void declaration(std::size_t) {
+            ++executed[static_cast<std::size_t>(element::data)];
+        }
+
+        void instruction(std::size_t index) {
+            ++executed[static_cast<std::size_t>(kinds[index])];
+            if (index == next_lap) {
+                lap(index / region_size);
+                next_lap += region_size;
+            }
+        }
+
+        void read(ComputerMemory::vars_size_t address) {
+            ++heat[address].reads;
+        }
+
+        void write(ComputerMemory::vars_size_t address) {
+            ++heat[address].writes;
+        }
+
+        void retired(std::size_t, const Effect &) {
+        }
+
+        // Returns how many times functions of the given kind ran over all profiled boots.
+        [[nodiscard]] uint64_t executions(element kind) const noexcept {
+            return executed[static_cast<std::size_t>(kind)];
+        }
+
+        // Returns reads and writes of every cell accessed at least once.
+        [[nodiscard]] const std::unordered_map<ComputerMemory::vars_size_t, Cell> &cells() const noexcept {
+            return heat;
+        }
+
+        [[nodiscard]] double declarations_seconds() const noexcept {
+            return declaration_seconds;
+        }
+
+        [[nodiscard]] std::vector<Region> regions() const {
+            std::vector<Region> result;
+            for (std::size_t r = 0; r < region_seconds.size(); ++r) {
+                std::size_t end = std::min(bc.code.size(), (r + 1) * region_size);
+                result.push_back({positions[r * region_size], positions[end - 1] + 1, region_seconds[r]});
+            }
+            return result;
+        }
+
+        // Writes the profile as lines of key=value pairs: executions of every kind of
+        // function, the [top] cells accessed most and the [top] slowest regions.
+        void report(std::ostream &os, std::size_t top = 10) const {
+            for (std::size_t k = 0; k < element_count; ++k)
+                os << "element=" << names[k] << " executed=" << executed[k] << '\n';
+
+            std::vector<std::pair<ComputerMemory::vars_size_t, Cell>> hottest(heat.begin(), heat.end());
+            auto accesses = [](const Cell &c) { return c.reads + c.writes; };
+            std::sort(hottest.begin(), hottest.end(), [&](const auto &a, const auto &b) {
+                return accesses(a.second) != accesses(b.second) ? accesses(a.second) > accesses(b.second)
+                                                                : a.first < b.first;
+            });
+            hottest.resize(std::min(top, hottest.size()));
+            for (const auto &[address, cell] : hottest)
+                os << "cell=" << address << " reads=" << cell.reads << " writes=" << cell.writes << '\n';
+
+            os << "declarations_seconds=" << declaration_seconds << '\n';
+            std::vector<Region> slowest = regions();
+            std::stable_sort(slowest.begin(), slowest.end(), [](const Region &a, const Region &b) {
+                return a.seconds > b.seconds;
+            });
+            slowest.resize(std::min(top, slowest.size()));
+            for (const auto &r : slowest)
+                os << "region_first=" << r.first << " region_last=" << r.last << " seconds=" << r.seconds << '\n';
+        }
+    };
+}
+
+#endif //OOASM_PROFILER_H
@@ -0,0 +1,97 @@
+#ifndef OOASM_PROGRAM_BUILDER_H
+#define OOASM_PROGRAM_BUILDER_H
+
+// Construction of large programs without a heap allocation per element.
+#include "arena.h"
+#include "ooasm.h"
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ooasm {
+    // Builds a program instruction by instruction. Elements of the language are created
+    // through the builder's methods, which mirror num(), mem(), mov()... and place them one
+    // after another in an arena handed over to the program. Every element keeps the arena
+    // alive, so it is freed in one release once the program and all its elements are gone.
+    //
+    //   ooasm::ProgramBuilder b;
+    //   b.append(b.mov(b.mem(b.num(0)), b.num(42)));
+    //   program p = b.build();
+    class ProgramBuilder {
+    private:
+        std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+        std::vector<std::shared_ptr<Function>> instructions;
+
+        template<typename T, typename... Args>
+        std::shared_ptr<T> make(Args &&... args) {
+            return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+        }
+
+    public:
+        void reserve(std::size_t count) {
+            instructions.reserve(count);
+        }
+
+        void append(std::shared_ptr<Function> instruction) {
+            instructions.push_back(std::move(instruction));
+        }
+
+        // Hands the instructions and the arena over to a new program and starts anew.
+        program build() {
+            program p(std::exchange(arena, std::make_shared<Arena>()), std::move(instructions));
+            instructions.clear();
+            return p;
+        }
+
+        std::shared_ptr<Num> num(int64_t val) {
+            return make<Num>(val);
+        }
+
+        std::shared_ptr<Lea> lea(const char *_id) {
+            return make<Lea>(_id);
+        }
+
+        std::shared_ptr<Mem> mem(std::shared_ptr<RValue> x) {
+            return make<Mem>(x);
+        }
+
+        std::shared_ptr<Data> data(const char *input, std::shared_ptr<Num> _num) {
+            return make<Data>(input, _num);
+        }
+
+        std::shared_ptr<Mov> mov(std::shared_ptr<LValue> _lval, std::shared_ptr<RValue> _rval) {
+            return make<Mov>(_lval, _rval);
+        }
+
+        std::shared_ptr<Add> add(std::shared_ptr<LValue> _lval, std::shared_ptr<RValue> _rval) {
+            return make<Add>(_lval, _rval);
+        }
+
+        std::shared_ptr<Sub> sub(std::shared_ptr<LValue> _lval, std::shared_ptr<RValue> _rval) {
+            return make<Sub>(_lval, _rval);
+        }
+
+        std::shared_ptr<Inc> inc(std::shared_ptr<LValue> _lval) {
+            return make<Inc>(_lval);
+        }
+
+        std::shared_ptr<Dec> dec(std::shared_ptr<LValue> _lval) {
+            return make<Dec>(_lval);
+        }
+
+        std::shared_ptr<One> one(std::shared_ptr<LValue> _lval) {
+            return make<One>(_lval);
+        }
+
+        std::shared_ptr<Ones> ones(std::shared_ptr<LValue> _lval) {
+            return make<Ones>(_lval);
+        }
+
+        std::shared_ptr<Onez> onez(std::shared_ptr<LValue> _lval) {
+            return make<Onez>(_lval);
+        }
+    };
+}
+
+#endif //OOASM_PROGRAM_BUILDER_H
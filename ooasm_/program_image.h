@@ -0,0 +1,319 @@
+#ifndef OOASM_PROGRAM_IMAGE_H
+#define OOASM_PROGRAM_IMAGE_H
+
+// Binary image of a loaded program: its bytecode as linked, optimized and bound,
+// so a program can be saved once and run from a file mapped into memory.
+//
+// All integers are little-endian and every section starts 8-byte aligned:
+//   offset 0:  magic "OOASMPG1"
+//   offset 8:  number of identifiers, unsigned 64-bit
+//   offset 16: number of declarations, unsigned 64-bit
+//   offset 24: number of instructions, unsigned 64-bit
+//   offset 32: 1 if some identifier was never declared, 0 otherwise, unsigned 64-bit
+//   offset 40: length of the table of identifiers in bytes, unsigned 64-bit
+//   offset 48: declarations, 16 bytes each:
+//              identifier (unsigned 32-bit), 4 zero bytes, value (signed 64-bit)
+//   then:      instructions, 32 bytes each:
+//              dst (signed 64-bit), src (signed 64-bit), dst depth (unsigned 32-bit),
+//              src depth (unsigned 32-bit), opcode, dst mode, src mode, 1 if the
+//              instruction sets flags (one byte each), 4 zero bytes
+//   then:      reach of every instruction, unsigned 64-bit (see Bytecode)
+//   then:      end of every identifier in the table, unsigned 64-bit
+//   then:      the table, identifiers one after another, padded with zeros to 8 bytes
+//
+// Declarations and instructions have the layout of Declaration and Instruction, so on
+// little-endian machines a mapped image is executed in place.
+#include "backend_cache.h"
+#include "bytecode.h"
+#include "computer_memory.h"
+#include "linker.h"
+#include "memory_image.h"
+#include "ooasm.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ooasm {
+    namespace image {
+        constexpr char program_magic[8] = {'O', 'O', 'A', 'S', 'M', 'P', 'G', '1'};
+        constexpr std::size_t program_header_size = 48;
+        constexpr std::size_t declaration_size = 16;
+        constexpr std::size_t instruction_size = 32;
+
+        static_assert(sizeof(Declaration) == declaration_size && offsetof(Declaration, value) == 8,
+                      "Declaration has to match its image");
+        static_assert(sizeof(Instruction) == instruction_size && offsetof(Instruction, dst_depth) == 16 &&
+                      offsetof(Instruction, op) == 24 && offsetof(Instruction, sets_flags) == 27,
+                      "Instruction has to match its image");
+
+        inline void put_u32(char *out, uint32_t value) {
+            for (int i = 0; i < 4; ++i)
+                out[i] = static_cast<char>(value >> (8 * i));
+        }
+
+        inline void put_u64(char *out, uint64_t value) {
+            for (int i = 0; i < 8; ++i)
+                out[i] = static_cast<char>(value >> (8 * i));
+        }
+
+        // Size of an image whose sections have the given lengths, or 0 if it is longer
+        // than [length]. Every section is checked against what is left of [length]
+        // before it is added, so that huge counts cannot wrap the sum around.
+        inline uint64_t program_size(uint64_t symbols, uint64_t declarations, uint64_t instructions,
+                                     uint64_t table, uint64_t length) {
+            const uint64_t counts[] = {declarations, instructions, symbols, table / 8 + (table % 8 != 0)};
+            const uint64_t widths[] = {declaration_size, instruction_size + 8, 8, 8};
+
+            uint64_t size = program_header_size;
+            for (std::size_t i = 0; i < 4; ++i) {
+                if (size > length || counts[i] > (length - size) / widths[i])
+                    return 0;
+                size += counts[i] * widths[i];
+            }
+            return size;
+        }
+    }
+
+    // Writes bound bytecode as a program image.
+    inline void write_bytecode(std::ostream &os, const Bytecode &bc) {
+        uint64_t table = 0;
+        for (const auto &id : bc.symbols)
+            table += id.size();
+
+        os.write(image::program_magic, sizeof(image::program_magic));
+        image::write_u64(os, bc.symbols.size());
+        image::write_u64(os, bc.declarations.size());
+        image::write_u64(os, bc.code.size());
+        image::write_u64(os, bc.unresolved ? 1 : 0);
+        image::write_u64(os, table);
+
+        for (const auto &d : bc.declarations) {
+            char out[image::declaration_size] = {};
+            image::put_u32(out, d.symbol);
+            image::put_u64(out + 8, static_cast<uint64_t>(d.value));
+            os.write(out, sizeof(out));
+        }
+
+        for (const auto &ins : bc.code) {
+            char out[image::instruction_size] = {};
+            image::put_u64(out, static_cast<uint64_t>(ins.dst));
+            image::put_u64(out + 8, static_cast<uint64_t>(ins.src));
+            image::put_u32(out + 16, ins.dst_depth);
+            image::put_u32(out + 20, ins.src_depth);
+            out[24] = static_cast<char>(ins.op);
+            out[25] = static_cast<char>(ins.dst_mode);
+            out[26] = static_cast<char>(ins.src_mode);
+            out[27] = static_cast<char>(ins.sets_flags ? 1 : 0);
+            os.write(out, sizeof(out));
+        }
+
+        for (auto r : bc.reach)
+            image::write_u64(os, r);
+
+        uint64_t end = 0;
+        for (const auto &id : bc.symbols) {
+            end += id.size();
+            image::write_u64(os, end);
+        }
+        for (const auto &id : bc.symbols)
+            os.write(id.data(), static_cast<std::streamsize>(id.size()));
+        for (uint64_t i = table; i % 8 != 0; ++i)
+            os.put('\0');
+    }
+
+    // Writes the program as an image.
+    inline void write_program(std::ostream &os, const program &p) {
+        write_bytecode(os, p.bytecode());
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    // Program image file mapped into memory and run in place, without building the
+    // elements of the language nor copying the bytecode. Pages of the file are read as
+    // the program touches them.
+    //
+    // Images are checked before they run, which reads the whole file once. Images known
+    // to come from write_program() may skip it with [validate] set to false.
+    class MappedProgram {
+    private:
+        void *base = MAP_FAILED;
+        std::size_t length = 0;
+        uint64_t symbol_count = 0;
+        const uint64_t *symbol_ends = nullptr;
+        const char *table = nullptr;
+        BytecodeView view;
+        mutable BackendCache cache;
+        mutable std::once_flag fingerprinted;
+        mutable Fingerprint digest;
+        mutable std::once_flag named;
+        mutable std::shared_ptr<ComputerMemory::vars_memory_t> vars;
+
+        [[nodiscard]] const char *at(std::size_t offset) const noexcept {
+            return static_cast<const char *>(base) + offset;
+        }
+
+        [[nodiscard]] uint64_t header(std::size_t offset) const noexcept {
+            uint64_t value;
+            std::memcpy(&value, at(offset), sizeof(value));
+            return value;
+        }
+
+        static bool valid_operand(mode m, uint32_t depth, bool unresolved) {
+            switch (m) {
+                case mode::imm:
+                    return depth == 0;
+                case mode::cell:
+                    return depth == 1;
+                case mode::indirect:
+                    return depth >= 2;
+                case mode::sym:
+                case mode::sym_cell:
+                case mode::sym_indirect:
+                    return unresolved;
+            }
+            return false;
+        }
+
+        // Checks that the bytecode is what the linker and the optimizer could have made,
+        // in particular that reach tells the truth, since static addresses are not
+        // checked at run time within it.
+        [[nodiscard]] bool valid() const {
+            for (const auto &d : view.declarations) {
+                if (d.symbol >= symbol_count)
+                    return false;
+            }
+
+            uint64_t previous = 0;
+            for (uint64_t i = 0; i < symbol_count; ++i) {
+                if (symbol_ends[i] < previous || symbol_ends[i] > header(40))
+                    return false;
+                previous = symbol_ends[i];
+            }
+
+            uint64_t reach = 0;
+            for (std::size_t i = 0; i < view.code.size(); ++i) {
+                const auto &ins = view.code[i];
+                auto raw = reinterpret_cast<const unsigned char *>(&ins);
+                if (raw[offsetof(Instruction, op)] > static_cast<uint8_t>(opcode::onez) ||
+                    raw[offsetof(Instruction, sets_flags)] > 1 ||
+                    !valid_operand(ins.dst_mode, ins.dst_depth, view.unresolved) || ins.dst_mode == mode::imm ||
+                    ins.dst_mode == mode::sym || !valid_operand(ins.src_mode, ins.src_depth, view.unresolved))
+                    return false;
+
+                reach = Linker::reach(reach, ins);
+                if (view.reach[i] != reach)
+                    return false;
+            }
+            return true;
+        }
+
+    public:
+        explicit MappedProgram(const std::string &path, bool validate = true) {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Cannot open program image");
+
+            struct stat st{};
+            if (fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= image::program_header_size) {
+                length = static_cast<std::size_t>(st.st_size);
+                base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+            close(fd);
+
+            if (length == 0)
+                throw std::invalid_argument("Not a program image");
+            if (base == MAP_FAILED)
+                throw std::runtime_error("Cannot map program image");
+            if (!image::little_endian() ||
+                std::memcmp(base, image::program_magic, sizeof(image::program_magic)) != 0) {
+                munmap(base, length);
+                throw std::invalid_argument("Not a program image");
+            }
+
+            symbol_count = header(8);
+            uint64_t declarations = header(16);
+            uint64_t instructions = header(24);
+            uint64_t size = image::program_size(symbol_count, declarations, instructions, header(40), length);
+            if (size == 0 || header(32) > 1) {
+                munmap(base, length);
+                throw std::invalid_argument("Not a program image");
+            }
+
+            std::size_t offset = image::program_header_size;
+            view.declarations = {reinterpret_cast<const Declaration *>(at(offset)), declarations};
+            offset += declarations * image::declaration_size;
+            view.code = {reinterpret_cast<const Instruction *>(at(offset)), instructions};
+            offset += instructions * image::instruction_size;
+            view.reach = {reinterpret_cast<const uint64_t *>(at(offset)), instructions};
+            offset += instructions * 8;
+            symbol_ends = reinterpret_cast<const uint64_t *>(at(offset));
+            table = at(offset + symbol_count * 8);
+            view.unresolved = header(32) == 1;
+
+            if (validate && !valid()) {
+                munmap(base, length);
+                throw std::invalid_argument("Not a program image");
+            }
+        }
+
+        MappedProgram(const MappedProgram &) = delete;
+
+        MappedProgram &operator=(const MappedProgram &) = delete;
+
+        ~MappedProgram() {
+            munmap(base, length);
+        }
+
+        [[nodiscard]] const BytecodeView &bytecode() const noexcept {
+            return view;
+        }
+
+        // What the backends derived from the code of the program, see backend_cache.h.
+        [[nodiscard]] BackendCache &backend_cache() const noexcept {
+            return cache;
+        }
+
+        // Fingerprint of the program, computed on first use.
+        [[nodiscard]] const Fingerprint &fingerprint() const {
+            std::call_once(fingerprinted, [this] { digest = ooasm::fingerprint(view); });
+            return digest;
+        }
+
+        // Addresses of the variables of the program by identifier, made on first use.
+        [[nodiscard]] const std::shared_ptr<ComputerMemory::vars_memory_t> &addresses() const {
+            std::call_once(named, [this] {
+                vars = Linker::addresses(view, [this](uint32_t i) { return identifier_t(symbol(i)); });
+            });
+            return vars;
+        }
+
+        [[nodiscard]] std::size_t symbols() const noexcept {
+            return static_cast<std::size_t>(symbol_count);
+        }
+
+        // Returns the identifier with index [i], as used by declarations.
+        [[nodiscard]] std::string_view symbol(std::size_t i) const {
+            if (i >= symbol_count)
+                throw std::out_of_range("No such identifier");
+
+            uint64_t begin = i == 0 ? 0 : symbol_ends[i - 1];
+            return {table + begin, static_cast<std::size_t>(symbol_ends[i] - begin)};
+        }
+    };
+#endif
+}
+
+#endif //OOASM_PROGRAM_IMAGE_H
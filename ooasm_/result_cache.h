@@ -0,0 +1,182 @@
+#ifndef OOASM_RESULT_CACHE_H
+#define OOASM_RESULT_CACHE_H
+
+// Cache of the results of boots.
+#include "bytecode.h"
+#include "computer_memory.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ooasm {
+    // Memory left by boots, keyed by the fingerprint of the program and the size of the
+    // memory. Every boot starts from zeroed memory, so a program booted on memory of
+    // the same size always leaves the same cells behind, and fails the same way if it
+    // fails: such failures are kept with the memory they left.
+    //
+    // Results are kept as their non-zero cells, found among the pages the boot wrote,
+    // and the least recently used ones are evicted once they hold more than [capacity]
+    // cells together. The cache may be shared by computers on several threads: results
+    // never change once kept, so they are copied in and out of memory without the lock.
+    class ResultCache {
+    private:
+        struct Key {
+            Fingerprint fingerprint;
+            ComputerMemory::vars_size_t size;
+
+            bool operator==(const Key &other) const noexcept {
+                return fingerprint == other.fingerprint && size == other.size;
+            }
+        };
+
+        struct KeyHash {
+            std::size_t operator()(const Key &key) const noexcept {
+                return static_cast<std::size_t>(key.fingerprint.low ^ (key.size * 0x9e3779b97f4a7c15));
+            }
+        };
+
+        struct Result {
+            std::vector<std::pair<ComputerMemory::vars_size_t, memory_word_t>> cells;
+            memory_word_t last_result;
+            ComputerMemory::vars_size_t last_index;
+            std::exception_ptr failure;
+        };
+
+        using entry_t = std::pair<Key, std::shared_ptr<const Result>>;
+
+        mutable std::mutex lock;
+        std::list<entry_t> recent;
+        std::unordered_map<Key, std::list<entry_t>::iterator, KeyHash> index;
+        std::size_t capacity;
+        std::size_t held = 0;
+        uint64_t hit_count = 0;
+        uint64_t miss_count = 0;
+        uint64_t eviction_count = 0;
+
+        static std::size_t cost(const Result &r) noexcept {
+            return r.cells.size() + 1;
+        }
+
+    public:
+        explicit ResultCache(std::size_t _capacity = std::size_t(1) << 24) : capacity(_capacity) {}
+
+        ResultCache(const ResultCache &) = delete;
+
+        ResultCache &operator=(const ResultCache &) = delete;
+
+        // Sets memory up with the result of the program on memory of its size, if there
+        // is one, and sets [failure] to the error the program failed with, if it did.
+        // Returns false, leaving memory alone, otherwise.
+        bool restore(const Fingerprint &fingerprint, ComputerMemory &cm, std::exception_ptr &failure) {
+            std::shared_ptr<const Result> r;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                auto it = index.find({fingerprint, cm.size});
+                if (it == index.end()) {
+                    ++miss_count;
+                    return false;
+                }
+
+                ++hit_count;
+                recent.splice(recent.begin(), recent, it->second);
+                r = it->second->second;
+            }
+
+            cm.setup();
+            for (const auto &[address, value] : r->cells)
+                cm.store_unchecked(address) = value;
+            cm.last_result = r->last_result;
+            cm.last_index = r->last_index;
+            failure = r->failure;
+            return true;
+        }
+
+        // Keeps the memory left by a boot of the program, which failed with [failure]
+        // unless it is null.
+        void store(const Fingerprint &fingerprint, const ComputerMemory &cm, std::exception_ptr failure = nullptr) {
+            auto r = std::make_shared<Result>(Result{{}, cm.last_result, cm.last_index, std::move(failure)});
+            std::vector<ComputerMemory::vars_size_t> pages = cm.dirty_pages;
+            std::sort(pages.begin(), pages.end());
+            for (auto page : pages) {
+                ComputerMemory::vars_size_t from = page << ComputerMemory::page_shift;
+                ComputerMemory::vars_size_t to = std::min(cm.mem.size(),
+                                                          from + (ComputerMemory::vars_size_t(1) << ComputerMemory::page_shift));
+                for (auto i = from; i < to; ++i) {
+                    if (cm.mem[i] != 0)
+                        r->cells.emplace_back(i, cm.mem[i]);
+                }
+            }
+            if (cost(*r) > capacity)
+                return;
+
+            // Results dropped here are freed after the lock is released.
+            std::list<entry_t> dropped;
+            std::lock_guard<std::mutex> guard(lock);
+            Key key{fingerprint, cm.size};
+            auto it = index.find(key);
+            if (it != index.end()) {
+                held -= cost(*it->second->second);
+                dropped.splice(dropped.end(), recent, it->second);
+                index.erase(it);
+            }
+
+            held += cost(*r);
+            recent.emplace_front(key, std::move(r));
+            index.emplace(key, recent.begin());
+            while (held > capacity) {
+                held -= cost(*recent.back().second);
+                index.erase(recent.back().first);
+                dropped.splice(dropped.end(), recent, std::prev(recent.end()));
+                ++eviction_count;
+            }
+        }
+
+        void clear() {
+            std::list<entry_t> dropped;
+            std::lock_guard<std::mutex> guard(lock);
+            dropped.swap(recent);
+            index.clear();
+            held = 0;
+        }
+
+        [[nodiscard]] uint64_t hits() const {
+            std::lock_guard<std::mutex> guard(lock);
+            return hit_count;
+        }
+
+        [[nodiscard]] uint64_t misses() const {
+            std::lock_guard<std::mutex> guard(lock);
+            return miss_count;
+        }
+
+        [[nodiscard]] uint64_t evictions() const {
+            std::lock_guard<std::mutex> guard(lock);
+            return eviction_count;
+        }
+
+        // Returns how many results are kept.
+        [[nodiscard]] std::size_t size() const {
+            std::lock_guard<std::mutex> guard(lock);
+            return index.size();
+        }
+
+        // Writes the counters as one line of key=value pairs.
+        void report(std::ostream &os) const {
+            std::lock_guard<std::mutex> guard(lock);
+            os << "cache_hits=" << hit_count << " cache_misses=" << miss_count
+               << " cache_evictions=" << eviction_count << " cache_results=" << index.size()
+               << " cache_cells=" << held - index.size() << '\n';
+        }
+    };
+}
+
+#endif //OOASM_RESULT_CACHE_H
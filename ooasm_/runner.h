@@ -0,0 +1,166 @@
+#ifndef OOASM_RUNNER_H
+#define OOASM_RUNNER_H
+
+// Execution of many independent boots on all cores of the machine.
+#include "computer_memory.h"
+#include "interpreter.h"
+#include "jit.h"
+#include "ooasm.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ooasm {
+    // Outcome of one job: final memory, or the error together with memory as it was
+    // when the error occurred.
+    struct RunResult {
+        std::vector<memory_word_t> memory;
+        std::exception_ptr error;
+    };
+
+    // Boots programs on a work-stealing pool of threads. Every worker has its own queue
+    // and its own ComputerMemory reused by all jobs it runs, so jobs share no mutable
+    // state. Idle workers steal jobs from the other queues.
+    class Runner {
+    public:
+        using callback_t = std::function<void(RunResult &&)>;
+
+    private:
+        struct Job {
+            std::shared_ptr<const program> p;
+            ComputerMemory::vars_size_t size;
+            callback_t done;
+        };
+
+        struct Worker {
+            std::mutex lock;
+            std::deque<Job> jobs;
+            ComputerMemory cm;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> queued{0};
+        std::mutex sleep_lock;
+        std::condition_variable wake;
+        bool stopping = false;
+
+        // Takes the newest job of the worker's own queue.
+        static bool pop(Worker &w, Job &job) {
+            std::lock_guard<std::mutex> guard(w.lock);
+            if (w.jobs.empty())
+                return false;
+
+            job = std::move(w.jobs.back());
+            w.jobs.pop_back();
+            return true;
+        }
+
+        // Takes the oldest job of some other worker's queue.
+        bool steal(std::size_t self, Job &job) {
+            for (std::size_t i = 1; i < workers.size(); ++i) {
+                Worker &victim = *workers[(self + i) % workers.size()];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if (!victim.jobs.empty()) {
+                    job = std::move(victim.jobs.front());
+                    victim.jobs.pop_front();
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        static void run(Worker &w, Job &job) {
+            RunResult result;
+            w.cm.size = job.size;
+            try {
+                w.cm.setup();
+                Interpreter(job.p->bytecode(), w.cm).declare();
+                Linker::check(job.p->bytecode());
+                execute(job.p->bytecode(), job.p->backend_cache().get<NativeProgram>(), w.cm, default_backend);
+            } catch (...) {
+                result.error = std::current_exception();
+            }
+
+            result.memory.assign(w.cm.mem.begin(), w.cm.mem.end());
+            job.done(std::move(result));
+        }
+
+        void work(std::size_t self) {
+            Worker &w = *workers[self];
+            while (true) {
+                Job job;
+                if (pop(w, job) || steal(self, job)) {
+                    --queued;
+                    run(w, job);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> guard(sleep_lock);
+                if (stopping && queued == 0)
+                    return;
+                wake.wait(guard, [this] { return queued > 0 || stopping; });
+            }
+        }
+
+    public:
+        // Starts [threads] workers, one per hardware thread by default.
+        explicit Runner(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+            for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i)
+                workers.push_back(std::make_unique<Worker>());
+            for (std::size_t i = 0; i < workers.size(); ++i)
+                workers[i]->thread = std::thread(&Runner::work, this, i);
+        }
+
+        Runner(const Runner &) = delete;
+
+        Runner &operator=(const Runner &) = delete;
+
+        // Finishes all submitted jobs and stops the workers.
+        ~Runner() {
+            {
+                std::lock_guard<std::mutex> guard(sleep_lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto &w : workers)
+                w->thread.join();
+        }
+
+        // Boots the program on a computer with [size] cells of memory. [done] is called
+        // on a worker thread with the result and must not throw.
+        void submit(std::shared_ptr<const program> p, ComputerMemory::vars_size_t size, callback_t done) {
+            Worker &w = *workers[next++ % workers.size()];
+            // Counted before it is published, so a thief taking it at once cannot bring
+            // the count below zero.
+            {
+                std::lock_guard<std::mutex> guard(sleep_lock);
+                ++queued;
+            }
+            {
+                std::lock_guard<std::mutex> guard(w.lock);
+                w.jobs.push_back({std::move(p), size, std::move(done)});
+            }
+            wake.notify_one();
+        }
+
+        std::future<RunResult> submit(std::shared_ptr<const program> p, ComputerMemory::vars_size_t size) {
+            auto promise = std::make_shared<std::promise<RunResult>>();
+            auto result = promise->get_future();
+            submit(std::move(p), size, [promise](RunResult &&r) { promise->set_value(std::move(r)); });
+            return result;
+        }
+    };
+}
+
+#endif //OOASM_RUNNER_H
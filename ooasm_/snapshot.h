@@ -0,0 +1,211 @@
+#ifndef OOASM_SNAPSHOT_H
+#define OOASM_SNAPSHOT_H
+
+// Snapshots of the state of the computer, shared page by page.
+#include "computer_memory.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ooasm {
+    // Memory, variables and flags at some point, kept as pages of memory in a tree of
+    // fanout 64 whose missing pages are zero. Snapshots never change once taken, and
+    // those taken from one another share every page and subtree neither wrote.
+    struct SnapshotState {
+        static constexpr ComputerMemory::vars_size_t fanout_shift = 6;
+        static constexpr ComputerMemory::vars_size_t fanout = 1 << fanout_shift;
+        static constexpr ComputerMemory::vars_size_t page_size = ComputerMemory::vars_size_t(1) << ComputerMemory::page_shift;
+
+        using page_t = std::array<memory_word_t, page_size>;
+
+        // Holds subtrees above the lowest level, and pages on it.
+        struct Node {
+            std::array<std::shared_ptr<const Node>, fanout> nodes;
+            std::array<std::shared_ptr<const page_t>, fanout> pages;
+        };
+
+        ComputerMemory::vars_size_t size;
+        memory_word_t last_result;
+        ComputerMemory::vars_size_t last_index;
+        // Shared with memory, which copies it before adding a variable to it.
+        std::shared_ptr<ComputerMemory::vars_memory_t> vars;
+        ComputerMemory::vars_size_t depth;
+        ComputerMemory::vars_size_t page_count;
+        std::shared_ptr<const Node> root;
+    };
+
+    // Value of a snapshot, copied in constant time, so that any number of computers may
+    // fork from it. See Computer::snapshot() and Computer::restore().
+    //
+    // Memory remembers the snapshot it was last saved to or restored from, and the pages
+    // written since. Taking a snapshot copies only those pages, and shares the rest with
+    // that snapshot. Restoring one rewrites only those pages and the pages where both
+    // snapshots differ, found by skipping the subtrees they share: memory that keeps
+    // forking from one snapshot pays only for the pages written in between.
+    class Snapshot {
+    private:
+        using vars_size_t = ComputerMemory::vars_size_t;
+        using Node = SnapshotState::Node;
+        using page_t = SnapshotState::page_t;
+
+        std::shared_ptr<const SnapshotState> state;
+
+        explicit Snapshot(std::shared_ptr<const SnapshotState> _state) : state(std::move(_state)) {}
+
+        static constexpr vars_size_t shift(vars_size_t level) noexcept {
+            return SnapshotState::fanout_shift * (level - 1);
+        }
+
+        static vars_size_t depth_of(vars_size_t pages) noexcept {
+            vars_size_t depth = 1;
+            while (depth * SnapshotState::fanout_shift < 64 && (pages - 1) >> shift(depth + 1) != 0)
+                ++depth;
+            return depth;
+        }
+
+        // Copies page [page] of memory, or returns null if it is zero.
+        static std::shared_ptr<const page_t> copy(const ComputerMemory &cm, vars_size_t page) {
+            vars_size_t from = page << ComputerMemory::page_shift;
+            vars_size_t to = std::min(cm.mem.size(), from + SnapshotState::page_size);
+            if (std::all_of(cm.mem.begin() + from, cm.mem.begin() + to, [](memory_word_t v) { return v == 0; }))
+                return nullptr;
+
+            auto p = std::make_shared<page_t>();
+            std::copy(cm.mem.begin() + from, cm.mem.begin() + to, p->begin());
+            std::fill(p->begin() + static_cast<std::ptrdiff_t>(to - from), p->end(), 0);
+            return p;
+        }
+
+        // Returns the subtree [base] at [level] with the sorted pages [first, last) copied
+        // from memory, counting pages added and dropped in [count].
+        static std::shared_ptr<const Node> build(const Node *base, vars_size_t level, const vars_size_t *first,
+                                                 const vars_size_t *last, const ComputerMemory &cm, vars_size_t &count) {
+            auto node = base != nullptr ? std::make_shared<Node>(*base) : std::make_shared<Node>();
+            while (first != last) {
+                vars_size_t slot = (*first >> shift(level)) & (SnapshotState::fanout - 1);
+                if (level == 1) {
+                    count -= node->pages[slot] != nullptr;
+                    node->pages[slot] = copy(cm, *first);
+                    count += node->pages[slot] != nullptr;
+                    ++first;
+                    continue;
+                }
+
+                const vars_size_t *next = std::find_if(first, last, [&](vars_size_t page) {
+                    return ((page >> shift(level)) & (SnapshotState::fanout - 1)) != slot;
+                });
+                node->nodes[slot] = build(node->nodes[slot].get(), level - 1, first, next, cm, count);
+                first = next;
+            }
+            return node;
+        }
+
+        // Appends the pages where subtrees [a] and [b] at [level] may differ.
+        static void diff(const Node *a, const Node *b, vars_size_t level, vars_size_t prefix,
+                         std::vector<vars_size_t> &pages) {
+            if (a == b)
+                return;
+
+            static const Node empty{};
+            const Node &x = a != nullptr ? *a : empty;
+            const Node &y = b != nullptr ? *b : empty;
+            for (vars_size_t slot = 0; slot < SnapshotState::fanout; ++slot) {
+                vars_size_t index = prefix << SnapshotState::fanout_shift | slot;
+                if (level == 1) {
+                    if (x.pages[slot] != y.pages[slot])
+                        pages.push_back(index);
+                } else {
+                    diff(x.nodes[slot].get(), y.nodes[slot].get(), level - 1, index, pages);
+                }
+            }
+        }
+
+        // Rewrites page [page] of memory with its content in the snapshot.
+        void write(ComputerMemory &cm, vars_size_t page) const {
+            const Node *node = state->root.get();
+            for (vars_size_t level = state->depth; level > 1 && node != nullptr; --level)
+                node = node->nodes[(page >> shift(level)) & (SnapshotState::fanout - 1)].get();
+            const page_t *p = node != nullptr ? node->pages[page & (SnapshotState::fanout - 1)].get() : nullptr;
+
+            vars_size_t from = page << ComputerMemory::page_shift;
+            vars_size_t to = std::min(cm.mem.size(), from + SnapshotState::page_size);
+            cm.mark(from);
+            for (vars_size_t i = from; i < to; ++i) {
+                memory_word_t v = p != nullptr ? (*p)[i - from] : 0;
+                if (cm.track_writes && cm.mem[i] != v)
+                    cm.log(i);
+                cm.mem[i] = v;
+            }
+        }
+
+    public:
+        // Takes a snapshot of memory, which then counts as saved to it.
+        static Snapshot take(ComputerMemory &cm) {
+            const SnapshotState *base = cm.origin.get();
+            std::vector<vars_size_t> pages = base != nullptr ? cm.unsaved_pages : cm.dirty_pages;
+            std::sort(pages.begin(), pages.end());
+
+            auto s = std::make_shared<SnapshotState>();
+            s->size = cm.mem.size();
+            s->last_result = cm.last_result;
+            s->last_index = cm.last_index;
+            s->vars = cm.vars;
+            s->depth = depth_of(std::max<vars_size_t>((s->size + SnapshotState::page_size - 1) >> ComputerMemory::page_shift, 1));
+            s->page_count = base != nullptr ? base->page_count : 0;
+            if (base != nullptr && pages.empty())
+                s->root = base->root;
+            else
+                s->root = build(base != nullptr ? base->root.get() : nullptr, s->depth, pages.data(),
+                                pages.data() + pages.size(), cm, s->page_count);
+
+            cm.origin = s;
+            cm.settle();
+            return Snapshot(std::move(s));
+        }
+
+        // Sets memory, variables and flags to those of the snapshot, resizing memory to
+        // its size. Memory then counts as restored from it.
+        void restore(ComputerMemory &cm) const {
+            const SnapshotState *base = cm.origin.get();
+            if (cm.mem.size() != state->size) {
+                cm.size = state->size;
+                cm.setup();
+                base = nullptr;
+            }
+
+            std::vector<vars_size_t> pages;
+            if (base != nullptr) {
+                pages = cm.unsaved_pages;
+                diff(base->root.get(), state->root.get(), state->depth, 0, pages);
+            } else {
+                pages = cm.dirty_pages;
+                diff(nullptr, state->root.get(), state->depth, 0, pages);
+            }
+            std::sort(pages.begin(), pages.end());
+            pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+            for (auto page : pages)
+                write(cm, page);
+
+            cm.vars = state->vars;
+            cm.last_result = state->last_result;
+            cm.last_index = state->last_index;
+            cm.origin = state;
+            cm.settle();
+        }
+
+        [[nodiscard]] vars_size_t size() const noexcept {
+            return state->size;
+        }
+
+        // Returns how many non-zero pages the snapshot holds, shared or not.
+        [[nodiscard]] vars_size_t pages() const noexcept {
+            return state->page_count;
+        }
+    };
+}
+
+#endif //OOASM_SNAPSHOT_H
@@ -0,0 +1,178 @@
+#ifndef OOASM_STORAGE_H
+#define OOASM_STORAGE_H
+
+// Zero-initialized cells of the computer's memory.
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define OOASM_STORAGE_MMAP 1
+#endif
+
+namespace ooasm {
+    // Array of memory words that commits memory only for the pages actually touched.
+    // Large arrays are anonymous mappings whose pages are zero until first written,
+    // so a memory of 2^32 cells costs only what the program writes. Small arrays,
+    // and large ones on systems without mmap, come from calloc.
+    template<typename Word>
+    class Storage {
+    public:
+        using value_type = Word;
+        using size_type = std::size_t;
+        using iterator = Word *;
+        using const_iterator = const Word *;
+
+    private:
+        static constexpr size_type page_bytes = 4096;
+        static constexpr size_type mapping_threshold = 1 << 20;
+
+        Word *words = nullptr;
+        size_type count = 0;
+        bool mapped = false;
+
+        static size_type bytes_of(size_type n) {
+            return (n * sizeof(Word) + page_bytes - 1) / page_bytes * page_bytes;
+        }
+
+        // Sizes whose bytes, rounded up to whole pages, would not fit in size_type are
+        // rejected before anything is computed from them.
+        void allocate(size_type n) {
+            if (n == 0)
+                return;
+            if (n > (SIZE_MAX - page_bytes) / sizeof(Word))
+                throw std::bad_alloc();
+
+#ifdef OOASM_STORAGE_MMAP
+            if (n * sizeof(Word) >= mapping_threshold) {
+                void *p = mmap(nullptr, bytes_of(n), PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+                if (p == MAP_FAILED)
+                    throw std::bad_alloc();
+
+                words = static_cast<Word *>(p);
+                mapped = true;
+                count = n;
+                return;
+            }
+#endif
+            words = static_cast<Word *>(std::calloc(n, sizeof(Word)));
+            if (words == nullptr)
+                throw std::bad_alloc();
+            count = n;
+        }
+
+        // Zeroes every cell. Pages of a mapping are given back to the system, which maps
+        // them zeroed on the next touch, rather than written over and so committed.
+        void clear() {
+#if defined(OOASM_STORAGE_MMAP) && defined(__linux__)
+            if (mapped && madvise(words, bytes_of(count), MADV_DONTNEED) == 0)
+                return;
+#endif
+            zero(0, count);
+        }
+
+        void release() noexcept {
+#ifdef OOASM_STORAGE_MMAP
+            if (mapped)
+                munmap(words, bytes_of(count));
+            else
+#endif
+                std::free(words);
+
+            words = nullptr;
+            count = 0;
+            mapped = false;
+        }
+
+    public:
+        Storage() = default;
+
+        explicit Storage(size_type n) {
+            allocate(n);
+        }
+
+        Storage(const Storage &other) : Storage(other.count) {
+            std::copy(other.begin(), other.end(), begin());
+        }
+
+        Storage(Storage &&other) noexcept
+                : words(std::exchange(other.words, nullptr)), count(std::exchange(other.count, 0)),
+                  mapped(std::exchange(other.mapped, false)) {}
+
+        Storage &operator=(Storage other) noexcept {
+            std::swap(words, other.words);
+            std::swap(count, other.count);
+            std::swap(mapped, other.mapped);
+            return *this;
+        }
+
+        ~Storage() {
+            release();
+        }
+
+        // Makes the storage hold [n] copies of [value], reusing the allocation if the size is unchanged.
+        void assign(size_type n, Word value) {
+            if (n != count) {
+                release();
+                allocate(n);
+            } else {
+                clear();
+            }
+
+            if (value != 0)
+                std::fill(begin(), end(), value);
+        }
+
+        // Zeroes cells [from, to).
+        void zero(size_type from, size_type to) {
+            std::fill(words + from, words + to, 0);
+        }
+
+        Word &operator[](size_type index) noexcept {
+            return words[index];
+        }
+
+        const Word &operator[](size_type index) const noexcept {
+            return words[index];
+        }
+
+        Word *data() noexcept {
+            return words;
+        }
+
+        const Word *data() const noexcept {
+            return words;
+        }
+
+        [[nodiscard]] size_type size() const noexcept {
+            return count;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return count == 0;
+        }
+
+        iterator begin() noexcept {
+            return words;
+        }
+
+        iterator end() noexcept {
+            return words + count;
+        }
+
+        const_iterator begin() const noexcept {
+            return words;
+        }
+
+        const_iterator end() const noexcept {
+            return words + count;
+        }
+    };
+}
+
+#endif //OOASM_STORAGE_H
@@ -0,0 +1,91 @@
+#ifndef OOASM_STREAM_H
+#define OOASM_STREAM_H
+
+// Execution of programs too long to be held in memory, pulled from a source in chunks.
+#include "bytecode.h"
+#include "computer_memory.h"
+#include "interpreter.h"
+#include "linker.h"
+#include "ooasm.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ooasm {
+    // Runs a program whose elements are pulled from a source, a callable returning the
+    // next element or an empty pointer once the program ends. Elements are lowered,
+    // linked and executed [chunk] at a time and released before the next chunk is pulled,
+    // so memory does not grow with the length of the program.
+    //
+    // Declarations have to come first: a data() after the first instruction throws an
+    // error, since instructions before it have already run. For the same reason an
+    // identifier that was never declared fails when its chunk is reached, after the
+    // previous chunks have run. Chunks are interpreted as lowered, without optimizations
+    // or native code, which would not pay off for code that runs once.
+    class Stream {
+    private:
+        ComputerMemory &cm;
+        std::vector<std::shared_ptr<Function>> elements;
+        bool code = false;
+
+        // Lowers pulled elements and checks that declarations precede all instructions.
+        Bytecode lower() {
+            Assembler as;
+            for (const auto &element : elements) {
+                std::size_t declared = as.declared();
+                element->assemble(as);
+                if (as.declared() != declared && (code || as.emitted() != 0))
+                    throw std::invalid_argument("Declaration after code");
+            }
+            elements.clear();
+            return as.finish();
+        }
+
+        // Declares variables of the chunk and runs its instructions. Identifiers are
+        // resolved with the cells declared so far.
+        void run(Bytecode &bc) {
+            for (const auto &d : bc.declarations)
+                cm.store(cm.add(bc.symbols[d.symbol])) = d.value;
+            if (bc.code.empty())
+                return;
+
+            code = true;
+            Linker::resolve(bc, cm.vars.get());
+            Linker::check(bc);
+            Linker::bind(bc);
+            Interpreter(bc, cm).execute();
+        }
+
+    public:
+        static constexpr std::size_t default_chunk = 4096;
+
+        explicit Stream(ComputerMemory &_cm) : cm(_cm) {}
+
+        // Runs the program pulled from [next] on memory prepared by setup().
+        template<typename Source>
+        void run(Source &&next, std::size_t chunk = default_chunk) {
+            if (chunk == 0)
+                chunk = 1;
+
+            elements.reserve(chunk);
+            for (bool more = true; more;) {
+                while (elements.size() < chunk) {
+                    std::shared_ptr<Function> element = next();
+                    if (!element) {
+                        more = false;
+                        break;
+                    }
+                    elements.push_back(std::move(element));
+                }
+
+                Bytecode bc = lower();
+                run(bc);
+            }
+        }
+    };
+}
+
+#endif //OOASM_STREAM_H
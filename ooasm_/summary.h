@@ -0,0 +1,275 @@
+#ifndef OOASM_SUMMARY_H
+#define OOASM_SUMMARY_H
+
+// Summaries of whole programs: their effect on memory as one function of the values
+// of their variables.
+#include "backend_cache.h"
+#include "bytecode.h"
+#include "computer_memory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ooasm {
+    // Effect of linked, bound code whose addresses are all static. Without jumps, such
+    // code always writes the same cells, and since addition and subtraction wrap, every
+    // value it computes is an affine expression over the values of the declared cells
+    // when it starts, all other cells being zero. ones() and onez() reading flags that
+    // depend on those values add guards: such a cell ends up as one if any of its
+    // guards holds and as its expression otherwise.
+    //
+    // Applying a summary costs as much as the cells it writes and their expressions,
+    // instead of as much as the code. Code reading a guarded cell again, with
+    // expressions of more than [max_terms] variables, or with a summary no smaller than
+    // the code has none.
+    class Summary {
+    public:
+        static constexpr std::size_t max_terms = 64;
+
+    private:
+        struct Term {
+            uint32_t input;
+            uint64_t coefficient;
+        };
+
+        // constant + sum of coefficient * input over terms [first, last).
+        struct Expression {
+            uint64_t constant;
+            uint32_t first;
+            uint32_t last;
+        };
+
+        // Holds if the result of [condition] is zero, with [zero], or negative otherwise.
+        struct Guard {
+            bool zero;
+            Expression condition;
+        };
+
+        struct Output {
+            ComputerMemory::vars_size_t cell;
+            Expression value;
+            uint32_t first_guard;
+            uint32_t last_guard;
+        };
+
+        // Expression while the code is summarized, with terms sorted by input.
+        struct Affine {
+            uint64_t constant = 0;
+            std::vector<std::pair<uint32_t, uint64_t>> terms;
+        };
+
+        struct Value {
+            Affine affine;
+            std::vector<std::pair<bool, Affine>> guards;
+        };
+
+        std::vector<Term> terms;
+        std::vector<Guard> guards;
+        std::vector<Output> outputs;
+        Expression flags{};
+        uint64_t reach = 0;
+
+        static Affine combine(const Affine &a, const Affine &b, bool subtract) {
+            Affine r;
+            r.constant = subtract ? a.constant - b.constant : a.constant + b.constant;
+            auto i = a.terms.begin(), j = b.terms.begin();
+            while (i != a.terms.end() || j != b.terms.end()) {
+                if (j == b.terms.end() || (i != a.terms.end() && i->first < j->first)) {
+                    r.terms.push_back(*i++);
+                } else {
+                    uint64_t c = subtract ? uint64_t(0) - j->second : j->second;
+                    if (i != a.terms.end() && i->first == j->first)
+                        c += (i++)->second;
+                    if (c != 0)
+                        r.terms.emplace_back(j->first, c);
+                    ++j;
+                }
+            }
+            return r;
+        }
+
+        static bool holds(bool zero, uint64_t result) noexcept {
+            return zero ? result == 0 : static_cast<memory_word_t>(result) < 0;
+        }
+
+        Expression flatten(const Affine &a) {
+            Expression e{a.constant, static_cast<uint32_t>(terms.size()), 0};
+            for (const auto &[input, coefficient] : a.terms)
+                terms.push_back({input, coefficient});
+            e.last = static_cast<uint32_t>(terms.size());
+            return e;
+        }
+
+        [[nodiscard]] uint64_t evaluate(const Expression &e, const ComputerMemory &cm) const noexcept {
+            uint64_t v = e.constant;
+            for (uint32_t t = e.first; t < e.last; ++t)
+                v += terms[t].coefficient * static_cast<uint64_t>(cm.mem[terms[t].input]);
+            return v;
+        }
+
+    public:
+        // Summarizes bound code. Returns null if it has no summary.
+        static std::unique_ptr<Summary> build(const BytecodeView &bc) {
+            if (bc.code.empty() || bc.reach.size() != bc.code.size())
+                return nullptr;
+
+            auto declared = static_cast<uint64_t>(bc.declarations.size());
+            std::unordered_map<uint64_t, Value> cells;
+            std::vector<uint64_t> written;
+            Affine flags{1, {}};
+
+            // Value of a cell not written yet.
+            auto initial = [&](uint64_t address) {
+                Value v;
+                if (address < declared)
+                    v.affine.terms.emplace_back(static_cast<uint32_t>(address), 1);
+                return v;
+            };
+            auto cell = [&](uint64_t address) -> Value & {
+                auto [it, inserted] = cells.try_emplace(address);
+                if (inserted) {
+                    it->second = initial(address);
+                    written.push_back(address);
+                }
+                return it->second;
+            };
+            // Reads an operand, failing on guarded cells.
+            auto read = [&](mode m, memory_word_t operand, Affine &out) {
+                if (m == mode::imm) {
+                    out = Affine{static_cast<uint64_t>(operand), {}};
+                    return true;
+                }
+                auto it = cells.find(static_cast<uint64_t>(operand));
+                if (it == cells.end()) {
+                    out = initial(static_cast<uint64_t>(operand)).affine;
+                    return true;
+                }
+                out = it->second.affine;
+                return it->second.guards.empty();
+            };
+
+            for (const auto &ins : bc.code) {
+                if (ins.dst_mode != mode::cell || (ins.src_mode != mode::imm && ins.src_mode != mode::cell))
+                    return nullptr;
+                auto dst = static_cast<uint64_t>(ins.dst);
+
+                switch (ins.op) {
+                    case opcode::mov: {
+                        Affine src;
+                        if (!read(ins.src_mode, ins.src, src))
+                            return nullptr;
+                        cell(dst) = Value{std::move(src), {}};
+                        break;
+                    }
+                    case opcode::add:
+                    case opcode::sub: {
+                        Affine a, b;
+                        if (!read(ins.dst_mode, ins.dst, a) || !read(ins.src_mode, ins.src, b))
+                            return nullptr;
+                        Affine r = combine(a, b, ins.op == opcode::sub);
+                        if (r.terms.size() > max_terms)
+                            return nullptr;
+                        if (ins.sets_flags)
+                            flags = r;
+                        cell(dst) = Value{std::move(r), {}};
+                        break;
+                    }
+                    case opcode::one:
+                        cell(dst) = Value{Affine{1, {}}, {}};
+                        break;
+                    case opcode::ones:
+                    case opcode::onez: {
+                        bool zero = ins.op == opcode::onez;
+                        if (flags.terms.empty()) {
+                            if (holds(zero, flags.constant))
+                                cell(dst) = Value{Affine{1, {}}, {}};
+                        } else {
+                            Value &v = cell(dst);
+                            if (v.guards.size() == max_terms)
+                                return nullptr;
+                            v.guards.emplace_back(zero, flags);
+                        }
+                        break;
+                    }
+                }
+            }
+
+            auto summary = std::make_unique<Summary>();
+            summary->reach = bc.reach.back();
+            for (auto address : written) {
+                const Value &v = cells[address];
+                Output out{static_cast<ComputerMemory::vars_size_t>(address), summary->flatten(v.affine),
+                           static_cast<uint32_t>(summary->guards.size()), 0};
+                for (const auto &[zero, condition] : v.guards)
+                    summary->guards.push_back({zero, summary->flatten(condition)});
+                out.last_guard = static_cast<uint32_t>(summary->guards.size());
+                summary->outputs.push_back(out);
+            }
+            summary->flags = summary->flatten(flags);
+
+            if (summary->cost() >= bc.code.size())
+                return nullptr;
+            return summary;
+        }
+
+        // Returns how many cells, terms and guards applying the summary goes through.
+        [[nodiscard]] std::size_t cost() const noexcept {
+            return outputs.size() + terms.size() + guards.size();
+        }
+
+        [[nodiscard]] std::size_t cells() const noexcept {
+            return outputs.size();
+        }
+
+        // Applies the summary to memory set up by the declarations. Returns false, having
+        // done nothing, if the code accesses cells past the memory, so that it fails
+        // where it would when executed.
+        bool apply(ComputerMemory &cm) const {
+            if (reach > cm.mem.size())
+                return false;
+
+            std::vector<memory_word_t> values(outputs.size());
+            for (std::size_t i = 0; i < outputs.size(); ++i) {
+                const Output &out = outputs[i];
+                bool guarded = false;
+                for (uint32_t g = out.first_guard; g < out.last_guard && !guarded; ++g)
+                    guarded = holds(guards[g].zero, evaluate(guards[g].condition, cm));
+                values[i] = guarded ? 1 : static_cast<memory_word_t>(evaluate(out.value, cm));
+            }
+            cm.last_result = static_cast<memory_word_t>(evaluate(flags, cm));
+
+            for (std::size_t i = 0; i < outputs.size(); ++i)
+                cm.store_unchecked(outputs[i].cell) = values[i];
+            return true;
+        }
+    };
+
+    // Summary of a program, made on its second boot so that programs booted once never
+    // pay for it, and shared by copies of the program and by all threads booting it.
+    class SummarizedProgram {
+    public:
+        static constexpr backend_data slot = backend_data::summary;
+
+    private:
+        std::atomic<bool> booted{false};
+        std::once_flag once;
+        std::unique_ptr<Summary> summary;
+
+    public:
+        // Returns the summary, or null on the first boot and for code without one.
+        const Summary *get(const BytecodeView &bc) {
+            if (!booted.exchange(true, std::memory_order_relaxed))
+                return nullptr;
+            std::call_once(once, [this, &bc] { summary = Summary::build(bc); });
+            return summary.get();
+        }
+    };
+}
+
+#endif //OOASM_SUMMARY_H
@@ -0,0 +1,251 @@
+#ifndef OOASM_TRACER_H
+#define OOASM_TRACER_H
+
+// Traces of boots: the last instructions run, with what each of them did.
+//
+// Traces are flushed as binary files, all integers little-endian:
+//   offset 0:  magic "OOASMTR1"
+//   offset 8:  sequence number of the first record, unsigned 64-bit; earlier records
+//              were overwritten before the flush
+//   offset 16: number of records, unsigned 64-bit
+//   offset 24: records, 33 bytes each: position of the function in the program
+//              (unsigned 64-bit), address written (unsigned 64-bit), value before and
+//              after (signed 64-bit each), flags (one byte, see TraceRecord)
+//
+// tools/trace_decode.cc prints them as text.
+#include "bytecode.h"
+#include "computer_memory.h"
+#include "interpreter.h"
+#include "linker.h"
+#include "memory_image.h"
+#include "ooasm.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace ooasm {
+    struct TraceRecord {
+        static constexpr uint8_t wrote = 1, zero = 2, sign = 4;
+
+        uint64_t position;
+        uint64_t address;
+        memory_word_t before;
+        memory_word_t after;
+        // [wrote] unless the instruction was a conditional write not taken, [zero] and
+        // [sign] as ZF and SF once it completed.
+        uint8_t flags;
+    };
+
+    // Records read back from a trace file.
+    struct Trace {
+        uint64_t first = 0;
+        std::vector<TraceRecord> records;
+    };
+
+    namespace image {
+        constexpr char trace_magic[8] = {'O', 'O', 'A', 'S', 'M', 'T', 'R', '1'};
+        constexpr std::size_t trace_record_size = 33;
+    }
+
+    // Observer of the interpreter recording the last [capacity] instructions of one
+    // program, see Computer::boot(Tracer &). Like profiled boots, traced boots interpret
+    // the program as lowered, so every record names the function of the program it
+    // comes from.
+    //
+    // The records live in a ring buffer written by the booting thread alone. Writing one
+    // is a few relaxed stores and a store to the head, with no lock, and flush() may run
+    // on another thread at the same time: records overwritten while they are copied are
+    // dropped from the flush instead of being waited for, as in a seqlock. The buffer has
+    // at least one slot more than it keeps, for the record being written.
+    class Tracer {
+    private:
+        // Record as written while tracing, turned into a TraceRecord when flushed. Fields
+        // are atomic since flush() may read them while they are written; values are
+        // stored as unsigned.
+        struct Slot {
+            std::atomic<uint64_t> index;
+            std::atomic<uint64_t> address;
+            std::atomic<uint64_t> before;
+            std::atomic<uint64_t> after;
+            std::atomic<uint64_t> last_result;
+        };
+
+        // Fields of a slot as copied by flush().
+        struct Copy {
+            uint64_t index;
+            uint64_t address;
+            memory_word_t before;
+            memory_word_t after;
+            memory_word_t last_result;
+        };
+
+        static constexpr uint64_t skipped = std::numeric_limits<uint64_t>::max();
+
+        Bytecode bc;
+        std::vector<std::size_t> positions;
+        std::unique_ptr<Slot[]> ring;
+        uint64_t kept;
+        uint64_t mask;
+        std::atomic<uint64_t> head{0};
+
+        static uint64_t round_up(uint64_t capacity) {
+            uint64_t c = 1;
+            while (c < capacity)
+                c <<= 1;
+            return c;
+        }
+
+    public:
+        explicit Tracer(program &p, std::size_t capacity = 1 << 16)
+                : bc(p.lower()), positions(p.positions()), kept(std::max<std::size_t>(capacity, 1)),
+                  mask(round_up(kept + 1) - 1) {
+            Linker::bind(bc);
+            ring = std::make_unique<Slot[]>(mask + 1);
+        }
+
+        [[nodiscard]] const Bytecode &bytecode() const noexcept {
+            return bc;
+        }
+
+        // Observer of the interpreter.
+        void declaration(std::size_t) {
+        }
+
+        void instruction(std::size_t) {
+        }
+
+        void read(ComputerMemory::vars_size_t) {
+        }
+
+        void write(ComputerMemory::vars_size_t) {
+        }
+
+        void retired(std::size_t index, const Effect &e) {
+            uint64_t h = head.load(std::memory_order_relaxed);
+            Slot &slot = ring[h & mask];
+            // Pairs with the fence of snapshot(): a reader seeing any of the stores below
+            // sees the head published before them, and drops the slot as torn.
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.index.store(index, std::memory_order_relaxed);
+            slot.address.store(e.wrote ? e.address : skipped, std::memory_order_relaxed);
+            slot.before.store(static_cast<uint64_t>(e.before), std::memory_order_relaxed);
+            slot.after.store(static_cast<uint64_t>(e.after), std::memory_order_relaxed);
+            slot.last_result.store(static_cast<uint64_t>(e.last_result), std::memory_order_relaxed);
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        [[nodiscard]] std::size_t capacity() const noexcept {
+            return static_cast<std::size_t>(kept);
+        }
+
+        // Returns how many instructions were recorded since the tracer was made or cleared.
+        [[nodiscard]] uint64_t recorded() const noexcept {
+            return head.load(std::memory_order_acquire);
+        }
+
+        void clear() noexcept {
+            head.store(0, std::memory_order_release);
+        }
+
+        // Returns the records still in the buffer, oldest first, and sets [first] to the
+        // sequence number of the oldest.
+        [[nodiscard]] std::vector<TraceRecord> snapshot(uint64_t &first) const {
+            uint64_t end = head.load(std::memory_order_acquire);
+            uint64_t begin = end > kept ? end - kept : 0;
+            std::vector<Copy> slots;
+            slots.reserve(static_cast<std::size_t>(end - begin));
+            for (uint64_t i = begin; i < end; ++i) {
+                const Slot &s = ring[i & mask];
+                slots.push_back({s.index.load(std::memory_order_relaxed), s.address.load(std::memory_order_relaxed),
+                                 static_cast<memory_word_t>(s.before.load(std::memory_order_relaxed)),
+                                 static_cast<memory_word_t>(s.after.load(std::memory_order_relaxed)),
+                                 static_cast<memory_word_t>(s.last_result.load(std::memory_order_relaxed))});
+            }
+
+            // Slots the writer reached again while they were copied may be torn, and so
+            // may the one it writes at [after], which it has not published yet.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = head.load(std::memory_order_relaxed) + 1;
+            uint64_t valid = after > mask + 1 ? after - (mask + 1) : 0;
+            std::size_t torn = valid > begin ? static_cast<std::size_t>(std::min(valid, end) - begin) : 0;
+
+            first = begin + torn;
+            std::vector<TraceRecord> records;
+            records.reserve(slots.size() - torn);
+            for (std::size_t i = torn; i < slots.size(); ++i) {
+                const Copy &s = slots[i];
+                TraceRecord r{};
+                r.position = positions[static_cast<std::size_t>(s.index)];
+                r.flags = static_cast<uint8_t>((s.last_result == 0 ? TraceRecord::zero : 0) |
+                                               (s.last_result < 0 ? TraceRecord::sign : 0));
+                if (s.address != skipped) {
+                    r.address = s.address;
+                    r.before = s.before;
+                    r.after = s.after;
+                    r.flags |= TraceRecord::wrote;
+                }
+                records.push_back(r);
+            }
+            return records;
+        }
+
+        // Writes the records still in the buffer as a trace file.
+        void flush(std::ostream &os) const {
+            uint64_t first;
+            std::vector<TraceRecord> records = snapshot(first);
+
+            os.write(image::trace_magic, sizeof(image::trace_magic));
+            image::write_u64(os, first);
+            image::write_u64(os, records.size());
+            for (const auto &r : records) {
+                image::write_u64(os, r.position);
+                image::write_u64(os, r.address);
+                image::write_u64(os, static_cast<uint64_t>(r.before));
+                image::write_u64(os, static_cast<uint64_t>(r.after));
+                os.put(static_cast<char>(r.flags));
+            }
+        }
+    };
+
+    // Reads a trace file written by Tracer::flush(). Throws an error if it is not one.
+    inline Trace read_trace(std::istream &is) {
+        auto u64 = [](const char *in) {
+            uint64_t value = 0;
+            for (int i = 7; i >= 0; --i)
+                value = value << 8 | static_cast<uint8_t>(in[i]);
+            return value;
+        };
+
+        char header[24];
+        if (!is.read(header, sizeof(header)) || std::memcmp(header, image::trace_magic, sizeof(image::trace_magic)) != 0)
+            throw std::invalid_argument("Not a trace");
+
+        Trace trace;
+        trace.first = u64(header + 8);
+        uint64_t count = u64(header + 16);
+        for (uint64_t i = 0; i < count; ++i) {
+            char in[image::trace_record_size];
+            if (!is.read(in, sizeof(in)))
+                throw std::invalid_argument("Truncated trace");
+
+            TraceRecord r{};
+            r.position = u64(in);
+            r.address = u64(in + 8);
+            r.before = static_cast<memory_word_t>(u64(in + 16));
+            r.after = static_cast<memory_word_t>(u64(in + 24));
+            r.flags = static_cast<uint8_t>(in[32]);
+            trace.records.push_back(r);
+        }
+        return trace;
+    }
+}
+
+#endif //OOASM_TRACER_H
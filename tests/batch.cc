@@ -0,0 +1,84 @@
+#include "batch.h"
+#include "computer.h"
+#include "ooasm.h"
+#include <cassert>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string memory_dump(const ooasm::BatchComputer &computer, std::size_t lane) {
+        std::stringstream ss;
+        computer.memory_dump(lane, ss);
+        return ss.str();
+    }
+} // namespace
+
+int main() {
+    auto ooasm_batch = program({
+            data("a", num(0)),
+            data("p", num(0)),
+            dec(mem(lea("a"))),
+            ones(mem(num(2))),
+            onez(mem(num(3))),
+            inc(mem(mem(lea("p")))),
+            mov(mem(num(4)), mem(mem(lea("p"))))
+    });
+
+    ooasm::BatchComputer computer1(5, 4);
+    computer1.boot(ooasm_batch, {{}, {1, 3}, {5, 1}, {7, 9}});
+
+    assert(!computer1.failed(0));
+    assert(memory_dump(computer1, 0) == "0 0 1 0 0 ");
+    assert(!computer1.failed(1));
+    assert(memory_dump(computer1, 1) == "0 3 0 2 2 ");
+    assert(!computer1.failed(2));
+    assert(memory_dump(computer1, 2) == "4 2 0 0 0 ");
+    assert(computer1.failed(3)); // mem(9) is out of bounds
+    assert(memory_dump(computer1, 3) == "6 9 0 0 0 ");
+
+    // Every lane agrees with a Computer booted on the same values.
+    auto ooasm_single = program({
+            data("a", num(5)),
+            data("p", num(1)),
+            dec(mem(lea("a"))),
+            ones(mem(num(2))),
+            onez(mem(num(3))),
+            inc(mem(mem(lea("p")))),
+            mov(mem(num(4)), mem(mem(lea("p"))))
+    });
+    Computer computer2(5);
+    computer2.boot(ooasm_single);
+    std::stringstream ss;
+    computer2.memory_dump(ss);
+    assert(ss.str() == memory_dump(computer1, 2));
+
+    auto ooasm_too_many = program({data("a", num(1)), data("b", num(2))});
+    ooasm::BatchComputer computer3(1, 2);
+    computer3.boot(ooasm_too_many, {{}, {3, 4}});
+    assert(computer3.failed(0) && computer3.failed(1));
+    assert(memory_dump(computer3, 0) == "1 ");
+    assert(memory_dump(computer3, 1) == "3 ");
+
+    // Ones and onez ignore operands out of bounds in lanes whose flag is clear, like
+    // Computer does, and fail only the lanes whose flag is set.
+    auto ooasm_flags = program({
+            add(mem(num(6)), mem(num(1))),
+            data("a", num(0)),
+            data("p", num(0)),
+            add(mem(lea("a")), num(0)),
+            ones(mem(num(9))),
+            onez(mem(mem(lea("p")))),
+            inc(mem(num(5)))
+    });
+    ooasm::BatchComputer computer4(8, 3);
+    computer4.boot(ooasm_flags, {{}, {-1, 0}, {2, 20}});
+    assert(!computer4.failed(0) && memory_dump(computer4, 0) == "1 0 0 0 0 1 0 0 ");
+    assert(computer4.failed(1) && memory_dump(computer4, 1) == "-1 0 0 0 0 0 0 0 ");
+    assert(!computer4.failed(2) && memory_dump(computer4, 2) == "2 20 0 0 0 1 20 0 ");
+    Computer computer5(8);
+    computer5.boot(ooasm_flags);
+    std::stringstream flags;
+    computer5.memory_dump(flags);
+    assert(flags.str() == memory_dump(computer4, 0));
+}
@@ -0,0 +1,53 @@
+#include "ct_ooasm.h"
+#include <cassert>
+#include <exception>
+
+namespace ct = ooasm::ct;
+
+int main() {
+    constexpr auto ooasm_move = ct::program(
+            ct::mov(ct::mem(ct::num(0)), ct::num(42))
+    );
+    static_assert(ct::boot<1>(ooasm_move).memory_dump() == "42 ");
+
+    constexpr auto ooasm_ones = ct::program(
+            ct::dec(ct::mem(ct::num(1))),
+            ct::ones(ct::mem(ct::num(0)))
+    );
+    static_assert(ct::boot<2>(ooasm_ones).memory_dump() == "1 -1 ");
+
+    constexpr auto ooasm_data = ct::program(
+            ct::inc(ct::mem(ct::lea("a"))),
+            ct::data("a", ct::num(0)),
+            ct::data("b", ct::num(2)),
+            ct::data("c", ct::num(3))
+    );
+    static_assert(ct::boot<4>(ooasm_data).memory_dump() == "1 2 3 0 ");
+
+    constexpr auto ooasm_operations = ct::program(
+            ct::data("a", ct::num(4)),
+            ct::data("b", ct::num(3)),
+            ct::data("c", ct::num(2)),
+            ct::data("d", ct::num(1)),
+            ct::add(ct::mem(ct::lea("a")), ct::mem(ct::lea("c"))),
+            ct::sub(ct::mem(ct::lea("b")), ct::mem(ct::lea("d"))),
+            ct::mov(ct::mem(ct::lea("c")), ct::num(0)),
+            ct::mov(ct::mem(ct::lea("d")), ct::num(0)),
+            ct::sub(ct::mem(ct::num(4)), ct::num(9223372036854775807)),
+            ct::dec(ct::mem(ct::num(4))),
+            ct::onez(ct::mem(ct::mem(ct::num(3))))
+    );
+    static_assert(ct::boot<5>(ooasm_operations).memory_dump() == "6 2 0 0 -9223372036854775808 ");
+
+    // The same programs run at run time as well, errors are reported with exceptions.
+    auto computer = ct::boot<4>(ooasm_data);
+    assert(computer.memory_dump() == "1 2 3 0 ");
+
+    try {
+        ct::boot<2>(ooasm_data);
+    } catch (std::exception &e) {
+        return 0;
+    }
+
+    assert(false);
+}
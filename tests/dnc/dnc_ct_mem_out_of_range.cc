@@ -0,0 +1,8 @@
+#include "ct_ooasm.h"
+
+namespace ct = ooasm::ct;
+
+int main() {
+    constexpr auto ooasm_mem_out_of_range = ct::program(ct::mov(ct::mem(ct::num(100)), ct::num(2)));
+    static_assert(ct::boot<11>(ooasm_mem_out_of_range).memory_dump() == "0 0 0 0 0 0 0 0 0 0 0 ");
+}
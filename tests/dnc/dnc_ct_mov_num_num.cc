@@ -0,0 +1,7 @@
+#include "ct_ooasm.h"
+
+namespace ct = ooasm::ct;
+
+int main() {
+    [[maybe_unused]] constexpr auto ooasm_mov_num_num = ct::program(ct::mov(ct::num(0), ct::num(2)));
+}
@@ -0,0 +1,7 @@
+#include "computer.h"
+#include "ooasm.h"
+
+int main() {
+    auto ooasm_program = program({mov(mem(num(0)), num(1))});
+    *ooasm_program.begin() = mov(mem(num(0)), num(42));
+}
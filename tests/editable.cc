@@ -0,0 +1,202 @@
+#include "computer.h"
+#include "editable.h"
+#include "ooasm.h"
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    // Boots the program and returns memory, with the error it failed with, if any.
+    template<typename Program>
+    std::string run(Computer &computer, Program &p) {
+        try {
+            computer.boot(p);
+        } catch (std::exception &e) {
+            return std::string(e.what()) + ": " + memory_dump(computer);
+        }
+        return memory_dump(computer);
+    }
+
+    const char *const names[] = {"a", "b", "c", "d", "e"};
+
+    // Instructions over variables a, b and c, over cells 8 to 19, past every variable,
+    // and through the pointer p to cell 10, so that programs run to the end in memory
+    // of 20 cells or more.
+    std::shared_ptr<ooasm::Function> random_element(std::mt19937 &gen) {
+        std::uniform_int_distribution<int> pick(0, 99);
+        auto lvalue = [&]() -> std::shared_ptr<ooasm::Mem> {
+            int choice = pick(gen);
+            if (choice < 60)
+                return mem(num(8 + pick(gen) % 12));
+            if (choice < 90)
+                return mem(lea(names[pick(gen) % 3]));
+            return mem(mem(lea("p")));
+        };
+        auto rvalue = [&]() -> std::shared_ptr<ooasm::RValue> {
+            if (pick(gen) % 3 == 0)
+                return num(pick(gen) % 9 - 4);
+            return lvalue();
+        };
+
+        switch (pick(gen) % 9) {
+            case 0:
+                return mov(lvalue(), rvalue());
+            case 1:
+            case 2:
+                return add(lvalue(), rvalue());
+            case 3:
+                return sub(lvalue(), rvalue());
+            case 4:
+                return inc(lvalue());
+            case 5:
+                return dec(lvalue());
+            case 6:
+                return one(lvalue());
+            case 7:
+                return ones(lvalue());
+            default:
+                return onez(lvalue());
+        }
+    }
+
+    program snapshot(const ooasm::EditableProgram &p) {
+        std::vector<std::shared_ptr<ooasm::Function>> elements;
+        for (std::size_t i = 0; i < p.size(); ++i)
+            elements.push_back(p.at(i));
+        return program(std::move(elements));
+    }
+}
+
+int main() {
+    // Every edit boots as the whole program would, whatever the size of the memory, and
+    // the boots after it resume from checkpoints left by the boots before it. Each size
+    // has a program of its own, since checkpoints are dropped when the size changes.
+    std::mt19937 gen(23);
+    std::uniform_int_distribution<int> pick(0, 999);
+    ooasm::EditableProgram p(16);
+    p.append(data("a", num(3)));
+    p.append(data("b", num(1)));
+    p.append(data("c", num(2)));
+    p.append(data("p", num(10)));
+    for (int i = 0; i < 2000; ++i)
+        p.append(random_element(gen));
+    ooasm::EditableProgram small = p;
+
+    std::size_t resumed = 0;
+    for (int round = 0; round < 300; ++round) {
+        // The first four declarations stay, at most two more are added after them, so
+        // variables stay below cell 8.
+        int choice = pick(gen);
+        std::size_t position = 4 + pick(gen) * (p.size() - 4) / 1000;
+        std::shared_ptr<ooasm::Function> element = choice < 10 ? data(names[pick(gen) % 5], num(pick(gen) % 7))
+                                                               : random_element(gen);
+        std::size_t declared = 0, added = 0;
+        for (std::size_t i = 0; i < p.size(); ++i) {
+            if (p.at(i)->is_definition() && ++declared > 4)
+                added = i;
+        }
+        bool definition = position < p.size() && p.at(position)->is_definition();
+        for (ooasm::EditableProgram *edited : {&p, &small}) {
+            if (choice < 10) {
+                if (declared < 6)
+                    edited->insert(position, element);
+            } else if (choice < 20) {
+                if (added != 0)
+                    edited->erase(added);
+            } else if (choice < 40) {
+                edited->append(element);
+            } else if (choice < 60) {
+                edited->insert(position, element);
+            } else if (definition) {
+                continue;
+            } else if (choice < 80) {
+                edited->replace(position, element);
+            } else {
+                edited->erase(position);
+            }
+        }
+
+        program whole = snapshot(p);
+        for (auto [edited, size] : {std::pair{&p, 32}, std::pair{&small, 20}}) {
+            Computer expected(size, ooasm::Backend::interpreter);
+            std::string result = run(expected, whole);
+            Computer computer(size);
+            for (int boot = 0; boot < 3; ++boot) {
+                assert(run(computer, *edited) == result);
+                resumed += boot == 0 && edited->resumed_from() != 0;
+            }
+        }
+    }
+    assert(resumed > 300);
+
+    // Edits near the end resume near the end, edits of declarations start over.
+    ooasm::EditableProgram counters(100);
+    counters.append(data("n", num(1)));
+    for (int i = 0; i < 10000; ++i)
+        counters.append(add(mem(num(1 + i % 8)), mem(lea("n"))));
+    Computer computer(16);
+    computer.boot(counters);
+    assert(counters.resumed_from() == 0 && counters.checkpoint_count() > 10);
+    assert(memory_dump(computer) == "1 1250 1250 1250 1250 1250 1250 1250 1250 0 0 0 0 0 0 0 ");
+
+    counters.replace(9990, inc(mem(num(9))));
+    computer.boot(counters);
+    assert(counters.resumed_from() >= 9000 && counters.resumed_from() <= 9989);
+    assert(memory_dump(computer) == "1 1250 1250 1250 1250 1250 1249 1250 1250 1 0 0 0 0 0 0 ");
+
+    counters.append(sub(mem(num(9)), num(1)));
+    counters.append(onez(mem(num(10))));
+    computer.boot(counters);
+    assert(counters.resumed_from() == 10000);
+    assert(memory_dump(computer) == "1 1250 1250 1250 1250 1250 1249 1250 1250 0 1 0 0 0 0 0 ");
+
+    counters.replace(0, data("n", num(2)));
+    computer.boot(counters);
+    assert(counters.resumed_from() == 0);
+    assert(memory_dump(computer) == "2 2500 2500 2500 2500 2500 2498 2500 2500 0 1 0 0 0 0 0 ");
+
+    // Identifiers declared later are found once their declaration is added.
+    counters.append(mov(mem(num(11)), mem(lea("m"))));
+    Computer again(16);
+    try {
+        again.boot(counters);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+        assert(std::string(e.what()) == "Variable not found");
+    }
+    counters.insert(1, data("m", num(7)));
+    again.boot(counters);
+    assert(counters.resumed_from() == 0);
+    assert(memory_dump(again) == "2 2507 2500 2500 2500 2500 2498 2500 2500 0 1 2507 0 0 0 0 ");
+
+    // Delta dumps see cells restored from checkpoints.
+    Computer tracked(16);
+    std::stringstream first, second;
+    tracked.boot(counters);
+    tracked.memory_dump_delta(first);
+    counters.erase(counters.size() - 1);
+    tracked.boot(counters);
+    tracked.memory_dump_delta(second);
+    ooasm::MemoryDelta delta = ooasm::read_delta(second);
+    assert(!delta.full && delta.changes.size() == 1 && delta.changes[0].first == 11 && delta.changes[0].second == 0);
+
+    try {
+        counters.erase(counters.size());
+        assert(false);
+    } catch (std::invalid_argument &e) {
+        assert(std::string(e.what()) == "No such element");
+    }
+}
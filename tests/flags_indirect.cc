@@ -0,0 +1,46 @@
+#include "computer.h"
+#include "ooasm.h"
+#include <cassert>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+} // namespace
+
+int main() {
+    auto ooasm_flags = program({
+            data("a", num(2)),
+            dec(mem(lea("a"))),
+            dec(mem(lea("a"))),
+            onez(mem(num(1))),
+            ones(mem(num(2))),
+            sub(mem(lea("a")), num(5)),
+            ones(mem(num(3))),
+            onez(mem(num(4))),
+            add(mem(num(5)), num(0)),
+            onez(mem(num(6))),
+            one(mem(num(7)))
+    });
+
+    Computer computer1(8);
+    computer1.boot(ooasm_flags);
+    assert(memory_dump(computer1) == "-5 1 0 1 0 0 1 1 ");
+
+    auto ooasm_indirect = program({
+            data("p", num(2)),
+            data("q", num(0)),
+            mov(mem(num(2)), num(3)),
+            mov(mem(mem(mem(lea("p")))), num(7)),
+            inc(mem(mem(lea("p")))),
+            mov(mem(lea("q")), mem(mem(num(0))))
+    });
+
+    Computer computer2(4);
+    computer2.boot(ooasm_indirect);
+    assert(memory_dump(computer2) == "2 4 4 7 ");
+}
@@ -0,0 +1,45 @@
+#include "computer.h"
+#include "ooasm.h"
+#include <cassert>
+#include <sstream>
+#include <string>
+#include <exception>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+} // namespace
+
+int main() {
+    auto ooasm_declared = program({
+            data("a", num(5)),
+            mov(mem(num(1)), mem(lea("a"))),
+            inc(mem(lea("a")))
+    });
+
+    Computer computer1(3);
+    computer1.boot(ooasm_declared);
+    assert(memory_dump(computer1) == "6 5 0 ");
+    computer1.boot(ooasm_declared); // Booting again starts from scratch
+    assert(memory_dump(computer1) == "6 5 0 ");
+
+    auto ooasm_not_declared = program({
+            data("a", num(5)),
+            mov(mem(num(1)), num(7)),
+            inc(mem(lea("b")))
+    });
+
+    Computer computer2(3);
+    try {
+        computer2.boot(ooasm_not_declared); // Should throw when linking
+    } catch (std::exception &e) {
+        assert(memory_dump(computer2) == "5 0 0 ");
+
+        return 0;
+    }
+
+    assert(false);
+}
@@ -0,0 +1,150 @@
+#include "computer.h"
+#include "jit.h"
+#include "ooasm.h"
+#include <cassert>
+#include <exception>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    // Boots the program with the given backend and returns memory, marking a failure with "!".
+    std::string run(program &p, int size, ooasm::Backend backend) {
+        Computer computer(size, backend);
+        try {
+            computer.boot(p);
+        } catch (std::exception &e) {
+            return "!" + memory_dump(computer);
+        }
+        return memory_dump(computer);
+    }
+
+    std::shared_ptr<ooasm::Mem> random_lvalue(std::mt19937 &gen) {
+        std::uniform_int_distribution<int> pick(0, 7);
+        int depth = pick(gen) < 5 ? 0 : pick(gen) % 3;
+        std::shared_ptr<ooasm::Mem> l = mem(num(pick(gen)));
+        for (int i = 0; i < depth; ++i)
+            l = mem(l);
+        return l;
+    }
+
+    std::shared_ptr<ooasm::RValue> random_rvalue(std::mt19937 &gen) {
+        std::uniform_int_distribution<int> pick(0, 7);
+        switch (pick(gen) % 4) {
+            case 0:
+                return num(pick(gen) - 2);
+            case 1:
+                return num(pick(gen) % 2 ? (int64_t(1) << 40) + pick(gen) : pick(gen));
+            default:
+                return random_lvalue(gen);
+        }
+    }
+
+    program random_program(std::mt19937 &gen) {
+        std::uniform_int_distribution<int> pick(0, 6);
+        std::vector<std::shared_ptr<ooasm::Function>> code;
+        code.push_back(data("a", num(pick(gen))));
+        for (int i = 0; i < 12; ++i) {
+            switch (pick(gen)) {
+                case 0:
+                    code.push_back(mov(random_lvalue(gen), random_rvalue(gen)));
+                    break;
+                case 1:
+                    code.push_back(add(random_lvalue(gen), random_rvalue(gen)));
+                    break;
+                case 2:
+                    code.push_back(sub(random_lvalue(gen), random_rvalue(gen)));
+                    break;
+                case 3:
+                    code.push_back(dec(random_lvalue(gen)));
+                    break;
+                case 4:
+                    code.push_back(one(random_lvalue(gen)));
+                    break;
+                case 5:
+                    code.push_back(ones(random_lvalue(gen)));
+                    break;
+                default:
+                    code.push_back(onez(random_lvalue(gen)));
+                    break;
+            }
+        }
+        return program(std::move(code));
+    }
+} // namespace
+
+int main() {
+    auto ooasm_simple = program({
+            data("a", num(5)),
+            mov(mem(num(3)), num(7)),
+            add(mem(num(3)), mem(lea("a"))),
+            mov(mem(num(1)), num(3)),
+            inc(mem(mem(num(1)))),
+            dec(mem(num(2))),
+            ones(mem(num(4))),
+            mov(mem(num(5)), num(int64_t(1) << 40)),
+            sub(mem(num(5)), mem(mem(num(1))))
+    });
+#ifdef OOASM_JIT_AVAILABLE
+    assert(ooasm_simple.backend_cache().get<ooasm::NativeProgram>().get(ooasm_simple.bytecode()) != nullptr);
+#endif
+    assert(run(ooasm_simple, 8, ooasm::Backend::jit) == "5 3 -1 13 1 1099511627763 0 0 ");
+
+    // A dynamic address out of bounds stops the program before the instruction writes.
+    auto ooasm_dynamic = program({
+            data("p", num(2)),
+            mov(mem(num(2)), num(9)),
+            inc(mem(num(1))),
+            mov(mem(mem(mem(lea("p")))), num(4)),
+            inc(mem(num(1)))
+    });
+    assert(run(ooasm_dynamic, 4, ooasm::Backend::jit) == "!2 1 9 0 ");
+
+    // Static addresses past the memory make the interpreter run the program.
+    assert(run(ooasm_dynamic, 2, ooasm::Backend::jit) == "!2 0 ");
+
+    // Rebooting zeroes cells written through dynamic addresses.
+    auto ooasm_pointer = program({
+            data("p", num(3)),
+            mov(mem(mem(lea("p"))), num(6))
+    });
+    Computer computer1(600, ooasm::Backend::jit);
+    computer1.boot(ooasm_pointer);
+    auto ooasm_other = program({
+            data("p", num(599)),
+            mov(mem(mem(lea("p"))), num(1))
+    });
+    computer1.boot(ooasm_other);
+    assert(memory_dump(computer1).substr(0, 12) == "599 0 0 0 0 ");
+
+    // Static addresses too far for a displacement.
+    auto ooasm_far = program({
+            data("p", num(300000000)),
+            mov(mem(mem(lea("p"))), num(3)),
+            add(mem(num(300000000)), num(4)),
+            mov(mem(num(1)), mem(num(300000000)))
+    });
+#ifdef OOASM_JIT_AVAILABLE
+    ooasm::ComputerMemory cm;
+    cm.size = 300000001;
+    cm.setup();
+    ooasm::Interpreter(ooasm_far.bytecode(), cm).declare();
+    assert(ooasm_far.backend_cache().get<ooasm::NativeProgram>().get(ooasm_far.bytecode())->run(cm));
+    assert(cm.mem[1] == 7 && cm.mem[300000000] == 7);
+#endif
+
+    std::mt19937 gen(14);
+    for (int i = 0; i < 2000; ++i) {
+        program p = random_program(gen);
+        for (int size : {3, 8})
+            assert(run(p, size, ooasm::Backend::jit) == run(p, size, ooasm::Backend::interpreter));
+    }
+}
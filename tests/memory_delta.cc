@@ -0,0 +1,97 @@
+#include "computer.h"
+#include "memory_image.h"
+#include "ooasm.h"
+#include <cassert>
+#include <exception>
+#include <sstream>
+#include <vector>
+
+namespace {
+    std::vector<int64_t> memory_image(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss, ooasm::dump_format::binary);
+        return ooasm::read_image(ss);
+    }
+
+    // Applies the next delta of the computer to [image] and returns the number of changes.
+    std::size_t follow(Computer &computer, std::vector<int64_t> &image) {
+        std::stringstream ss;
+        computer.memory_dump_delta(ss);
+        ooasm::MemoryDelta delta = ooasm::read_delta(ss);
+        ooasm::apply_delta(delta, image, 65536);
+        assert(image == memory_image(computer));
+        return delta.changes.size();
+    }
+} // namespace
+
+int main() {
+    auto ooasm_first = program({
+            data("a", num(7)),
+            mov(mem(num(5000)), num(1)),
+            mov(mem(num(1)), num(4999)),
+            inc(mem(mem(num(1))))
+    });
+    auto ooasm_second = program({
+            data("a", num(7)),
+            one(mem(num(60000))),
+            dec(mem(num(1))),
+            onez(mem(num(2)))
+    });
+    auto ooasm_mem_out_of_range = program({
+            mov(mem(num(3)), num(4)),
+            mov(mem(num(70000)), num(2))
+    });
+
+    Computer computer1(65536);
+    std::vector<int64_t> image;
+
+    computer1.boot(ooasm_first);
+    assert(follow(computer1, image) == 4); // The first delta holds every non-zero cell
+    assert(follow(computer1, image) == 0);
+
+    computer1.boot(ooasm_first);
+    assert(follow(computer1, image) == 0); // The same cells were written again
+
+    computer1.boot(ooasm_second);
+    assert(follow(computer1, image) == 4);
+
+    try {
+        computer1.boot(ooasm_mem_out_of_range);
+        assert(false);
+    } catch (std::exception &e) {
+    }
+    computer1.boot(ooasm_first);
+    try {
+        computer1.boot(ooasm_mem_out_of_range);
+        assert(false);
+    } catch (std::exception &e) {
+    }
+    assert(follow(computer1, image) == 4); // Cells zeroed by setup() count as changed
+
+    Computer computer2(3);
+    auto ooasm_small = program({
+            data("a", num(7)),
+            dec(mem(num(1)))
+    });
+    computer2.boot(ooasm_small);
+    assert(follow(computer2, image) == 2); // A new size starts a full delta
+    assert(image.size() == 3);
+
+    // Cells listed by a full delta count as written, so the next setup() reports them zeroed.
+    Computer computer3(65536);
+    std::vector<int64_t> image3;
+    computer3.boot(ooasm_first);
+    assert(follow(computer3, image3) == 4);
+    computer3.boot(ooasm_second);
+    assert(follow(computer3, image3) == 4);
+
+    // Sizes past what the caller expects are rejected before allocating.
+    std::stringstream huge;
+    ooasm::write_delta(huge, {uint64_t(1) << 60, true, {}});
+    try {
+        ooasm::apply_delta(ooasm::read_delta(huge), image, 65536);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+    }
+    assert(image.size() == 3);
+}
@@ -0,0 +1,90 @@
+#include "computer.h"
+#include "memory_image.h"
+#include "ooasm.h"
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main() {
+    auto ooasm_extremes = program({
+            data("min", num(std::numeric_limits<int64_t>::min())),
+            data("max", num(std::numeric_limits<int64_t>::max())),
+            mov(mem(num(2)), num(-1)),
+            mov(mem(num(3)), num(1234567890))
+    });
+
+    Computer computer1(100000);
+    computer1.boot(ooasm_extremes);
+
+    // Text dump is the same as streaming cells one by one.
+    std::stringstream fast, slow;
+    computer1.memory_dump(fast);
+    slow << std::numeric_limits<int64_t>::min() << ' ' << std::numeric_limits<int64_t>::max() << ' '
+         << -1 << ' ' << 1234567890 << ' ';
+    for (int i = 4; i < 100000; ++i)
+        slow << 0 << ' ';
+    assert(fast.str() == slow.str());
+
+    std::stringstream text;
+    computer1.memory_dump(text, ooasm::dump_format::text);
+    assert(text.str() == slow.str());
+
+    // Binary image loads back to the same cells.
+    std::stringstream binary;
+    computer1.memory_dump(binary, ooasm::dump_format::binary);
+    assert(binary.str().size() == 16 + 100000 * 8);
+    assert(binary.str().compare(0, 8, "OOASMEM1") == 0);
+
+    std::vector<int64_t> cells = ooasm::read_image(binary);
+    assert(cells.size() == 100000);
+    assert(cells[0] == std::numeric_limits<int64_t>::min());
+    assert(cells[1] == std::numeric_limits<int64_t>::max());
+    assert(cells[2] == -1 && cells[3] == 1234567890 && cells[4] == 0);
+
+    // And can be mapped by consumers.
+    const char *path = "memory_image_test.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        computer1.memory_dump(file, ooasm::dump_format::binary);
+    }
+    {
+        ooasm::MappedImage mapped(path);
+        assert(mapped.size() == 100000);
+        assert(std::vector<int64_t>(mapped.begin(), mapped.end()) == cells);
+    }
+    std::remove(path);
+
+    // Counts of cells past the end of the image are rejected, even when their size in
+    // bytes wraps around.
+    std::string huge("OOASMEM1\0\0\0\0\0\0\0\x20", 16);
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << huge;
+    }
+    try {
+        ooasm::MappedImage mapped(path);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+    }
+    std::remove(path);
+
+    std::stringstream truncated(huge + std::string(24, '\0'));
+    try {
+        ooasm::read_image(truncated);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+        assert(std::string(e.what()) == "Truncated memory image");
+    }
+
+    std::stringstream garbage("not an image at all");
+    try {
+        ooasm::read_image(garbage);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+    }
+}
@@ -0,0 +1,220 @@
+#include "computer.h"
+#include "interpreter.h"
+#include "linker.h"
+#include "ooasm.h"
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    // Runs the program as lowered and linked, without optimizations.
+    std::string reference_dump(program &p, int size, bool &failed) {
+        ooasm::Assembler as;
+        for (const auto &command : p)
+            command->assemble(as);
+        ooasm::Bytecode bc = as.finish();
+        ooasm::Linker::resolve(bc);
+
+        ooasm::ComputerMemory cm;
+        cm.size = size;
+        cm.setup();
+        failed = false;
+        try {
+            ooasm::Interpreter(bc, cm).run();
+        } catch (std::exception &e) {
+            failed = true;
+        }
+
+        std::string dump;
+        for (auto cell : cm.mem)
+            dump += std::to_string(cell) + " ";
+        return dump;
+    }
+
+    void check_same(program &p, int size) {
+        bool expected_failure;
+        std::string expected = reference_dump(p, size, expected_failure);
+
+        Computer computer(size);
+        bool failed = false;
+        try {
+            computer.boot(p);
+        } catch (std::exception &e) {
+            failed = true;
+        }
+
+        assert(failed == expected_failure);
+        assert(memory_dump(computer) == expected);
+    }
+
+    std::shared_ptr<ooasm::RValue> random_address(std::mt19937 &gen) {
+        std::uniform_int_distribution<int> pick(0, 9);
+        int kind = pick(gen);
+        if (kind < 6)
+            return num(pick(gen));
+        if (kind < 8)
+            return lea(pick(gen) % 2 ? "a" : "b");
+        return mem(num(pick(gen)));
+    }
+
+    std::shared_ptr<ooasm::LValue> random_lvalue(std::mt19937 &gen) {
+        return mem(random_address(gen));
+    }
+
+    std::shared_ptr<ooasm::RValue> random_rvalue(std::mt19937 &gen) {
+        std::uniform_int_distribution<int> pick(0, 3);
+        switch (pick(gen)) {
+            case 0:
+                return num(pick(gen) - 1);
+            case 1:
+                return random_address(gen);
+            default:
+                return mem(random_address(gen));
+        }
+    }
+
+    program random_program(std::mt19937 &gen) {
+        std::uniform_int_distribution<int> pick(0, 9);
+        std::vector<std::shared_ptr<ooasm::Function>> code;
+        code.push_back(data("a", num(pick(gen) - 2)));
+        code.push_back(data("b", num(pick(gen))));
+
+        int length = 1 + pick(gen) * 2;
+        for (int i = 0; i < length; ++i) {
+            switch (pick(gen)) {
+                case 0:
+                case 1:
+                    code.push_back(mov(random_lvalue(gen), random_rvalue(gen)));
+                    break;
+                case 2:
+                    code.push_back(add(random_lvalue(gen), random_rvalue(gen)));
+                    break;
+                case 3:
+                    code.push_back(sub(random_lvalue(gen), random_rvalue(gen)));
+                    break;
+                case 4:
+                    code.push_back(inc(random_lvalue(gen)));
+                    break;
+                case 5:
+                    code.push_back(dec(random_lvalue(gen)));
+                    break;
+                case 6:
+                    code.push_back(one(random_lvalue(gen)));
+                    break;
+                case 7:
+                    code.push_back(ones(random_lvalue(gen)));
+                    break;
+                default:
+                    code.push_back(onez(random_lvalue(gen)));
+                    break;
+            }
+        }
+
+        return program(std::move(code));
+    }
+} // namespace
+
+int main() {
+    auto ooasm_runs = program({
+            data("a", num(5)),
+            inc(mem(num(3))),
+            inc(mem(num(3))),
+            inc(mem(num(3))),
+            dec(mem(lea("a"))),
+            add(mem(lea("a")), num(4)),
+            sub(mem(lea("a")), num(9)),
+            onez(mem(num(1)))
+    });
+    // Increments of cell 3 merge into one addition, so do the operations on "a".
+    assert(ooasm_runs.bytecode().code.size() == 3);
+    Computer computer1(4);
+    computer1.boot(ooasm_runs);
+    assert(memory_dump(computer1) == "-1 0 0 3 ");
+
+    auto ooasm_dead = program({
+            mov(mem(num(2)), num(7)),
+            mov(mem(num(1)), num(3)),
+            mov(mem(num(2)), num(8)),
+            mov(mem(num(0)), mem(num(1))),
+            sub(mem(num(0)), num(3)),
+            onez(mem(num(1))),
+            ones(mem(num(2)))
+    });
+    // Cell 0 gets a literal, so the store to cell 1 is dead, and the flags are known.
+    // The first store to cell 2 stays, it shows if the memory is too small for it.
+    assert(ooasm_dead.bytecode().code.size() == 5);
+    computer1.boot(ooasm_dead);
+    assert(memory_dump(computer1) == "0 1 8 0 ");
+
+    // Only the arithmetic whose flags onez() reads, and the last one, record their result.
+    auto ooasm_flags = program({
+            data("a", num(1)),
+            data("b", num(1)),
+            dec(mem(lea("a"))),
+            dec(mem(lea("b"))),
+            onez(mem(num(2))),
+            inc(mem(lea("a")))
+    });
+    const auto &flags_code = ooasm_flags.bytecode().code;
+    assert(flags_code.size() == 4);
+    assert(!flags_code[0].sets_flags && flags_code[1].sets_flags && flags_code[3].sets_flags);
+    computer1.boot(ooasm_flags);
+    assert(memory_dump(computer1) == "1 0 1 0 ");
+
+    // Values past 16 bits still decide flags of 64-bit code. Code for 16-bit words, where
+    // 70000 wraps around, keeps the conditional write.
+    auto ooasm_wide = program({
+            mov(mem(num(1)), num(0)),
+            add(mem(num(1)), num(70000)),
+            ones(mem(num(2)))
+    });
+    assert(ooasm_wide.bytecode().code.size() == 2);
+    assert(ooasm_wide.bytecode(64).code.size() == 2);
+    assert(ooasm_wide.bytecode(16).code.size() == 3);
+    assert(ooasm_wide.bytecode(32).code.size() == 2);
+
+    // A failure keeps every write done before it, even those overwritten later.
+    auto ooasm_failing = program({
+            mov(mem(num(1)), num(7)),
+            mov(mem(num(10)), num(4)),
+            mov(mem(num(1)), num(2))
+    });
+    try {
+        computer1.boot(ooasm_failing);
+        assert(false);
+    } catch (std::exception &e) {
+        assert(memory_dump(computer1) == "0 7 0 0 ");
+    }
+
+    // Writes before the first access to a cell past the memory are kept too.
+    auto ooasm_unproven = program({
+            mov(mem(num(3)), num(1)),
+            inc(mem(num(3))),
+            mov(mem(num(3)), num(5)),
+            mov(mem(num(4)), num(2))
+    });
+    try {
+        computer1.boot(ooasm_unproven);
+        assert(false);
+    } catch (std::exception &e) {
+        assert(memory_dump(computer1) == "0 0 0 5 ");
+    }
+
+    std::mt19937 gen(2024);
+    for (int i = 0; i < 3000; ++i) {
+        program p = random_program(gen);
+        for (int size : {2, 4, 7, 12})
+            check_same(p, size);
+    }
+}
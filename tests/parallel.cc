@@ -0,0 +1,165 @@
+#include "computer.h"
+#include "jit.h"
+#include "ooasm.h"
+#include "parallel.h"
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    // Boots the program and returns memory, marking a failure with "!".
+    std::string run(Computer &computer, program &p) {
+        try {
+            computer.boot(p);
+        } catch (std::exception &e) {
+            return "!" + memory_dump(computer);
+        }
+        return memory_dump(computer);
+    }
+
+    // Instructions on [lanes] lanes of 16 cells each. Static instructions stay within
+    // a lane, and flags are read in the lane that set them, apart from the rare move
+    // across lanes and the rare barrier writing through a pointer.
+    program random_program(std::mt19937 &gen, int lanes, int length) {
+        std::uniform_int_distribution<int> pick(0, 999);
+        auto cell = [&](int lane) { return mem(num(lane * 16 + pick(gen) % 16)); };
+        auto operand = [&](int lane) -> std::shared_ptr<ooasm::RValue> {
+            if (pick(gen) % 2)
+                return cell(lane);
+            return num(pick(gen) % 100 - 50);
+        };
+
+        std::vector<std::shared_ptr<ooasm::Function>> code;
+        code.push_back(data("a", num(3)));
+        code.push_back(data("b", num(-2)));
+        int flags_lane = 0;
+        for (int i = 0; i < length; ++i) {
+            int lane = pick(gen) % lanes;
+            int choice = pick(gen);
+            if (choice < 250) {
+                code.push_back(add(cell(lane), operand(lane)));
+                flags_lane = lane;
+            } else if (choice < 500) {
+                code.push_back(sub(cell(lane), operand(lane)));
+                flags_lane = lane;
+            } else if (choice < 700) {
+                code.push_back(mov(cell(lane), operand(lane)));
+            } else if (choice < 780) {
+                code.push_back(inc(cell(lane)));
+                flags_lane = lane;
+            } else if (choice < 860) {
+                code.push_back(one(cell(lane)));
+            } else if (choice < 925) {
+                code.push_back(ones(cell(flags_lane)));
+            } else if (choice < 990) {
+                code.push_back(onez(cell(flags_lane)));
+            } else if (choice < 997) {
+                code.push_back(mov(cell(lane), cell(pick(gen) % lanes)));
+            } else if (choice < 999) {
+                code.push_back(onez(mem(mem(num(0)))));
+            } else {
+                code.push_back(add(mem(mem(num(1))), num(1)));
+            }
+        }
+        return program(std::move(code));
+    }
+
+    // Independent lanes and nothing else.
+    program lanes_program(int lanes, int length) {
+        std::vector<std::shared_ptr<ooasm::Function>> code;
+        for (int i = 0; i < length; ++i) {
+            int lane = i % lanes;
+            code.push_back(add(mem(num(lane * 2)), mem(num(lane * 2 + 1))));
+            code.push_back(inc(mem(num(lane * 2 + 1))));
+        }
+        return program(std::move(code));
+    }
+}
+
+int main() {
+    // Independent lanes split into one chain each.
+    program lanes = lanes_program(8, 2000);
+    const ooasm::Schedule &schedule = lanes.backend_cache().get<ooasm::ScheduledProgram>().get(lanes.bytecode());
+    assert(schedule.segments.size() == 1);
+    assert(schedule.segments[0].starts.size() == 9);
+    assert(schedule.segments[0].pages.size() == 1);
+    assert(schedule.segments[0].cells.size() == 16);
+
+    for (std::size_t threads : {1, 2, 4, 7}) {
+        Computer expected(16, ooasm::Backend::interpreter);
+        Computer computer(16, ooasm::Backend::parallel, threads);
+        assert(run(computer, lanes) == run(expected, lanes));
+        assert(run(computer, lanes) == run(expected, lanes));
+
+        // Copies keep the memory and run on threads of their own.
+        Computer copy = computer;
+        assert(memory_dump(copy) == memory_dump(computer));
+        assert(run(copy, lanes) == run(expected, lanes));
+        Computer assigned(4, ooasm::Backend::interpreter);
+        assigned = copy;
+        assert(run(assigned, lanes) == run(expected, lanes));
+    }
+
+    // Short programs are not worth splitting.
+    program short_lanes = lanes_program(8, 16);
+    assert(short_lanes.backend_cache().get<ooasm::ScheduledProgram>().get(short_lanes.bytecode()).segments.empty());
+
+    // Random programs run as the interpreter runs them, in memory large enough for
+    // them, too small for pointers and too small for static addresses.
+    std::mt19937 gen(20);
+    for (int round = 0; round < 40; ++round) {
+        program p = random_program(gen, 1 + round % 8, 2000 + 200 * (round % 20));
+        for (int size : {128, 100, 40}) {
+            Computer expected(size, ooasm::Backend::interpreter);
+            Computer computer(size, ooasm::Backend::parallel, 4);
+            assert(run(computer, p) == run(expected, p));
+        }
+    }
+
+    // Flags set in one chain are read by a barrier after the segment, and by a chain
+    // of the next segment.
+    std::vector<std::shared_ptr<ooasm::Function>> flagged;
+    flagged.push_back(data("p", num(9)));
+    for (int i = 0; i < 1500; ++i)
+        flagged.push_back(add(mem(num(2 + i % 6)), num(1)));
+    flagged.push_back(sub(mem(num(8)), num(1)));
+    flagged.push_back(ones(mem(mem(num(0)))));
+    flagged.push_back(ones(mem(num(1))));
+    for (int i = 0; i < 1500; ++i)
+        flagged.push_back(inc(mem(num(2 + i % 6))));
+    program flags(std::move(flagged));
+    {
+        Computer expected(10, ooasm::Backend::interpreter);
+        Computer computer(10, ooasm::Backend::parallel, 3);
+        assert(run(computer, flags) == run(expected, flags));
+        assert(memory_dump(computer) == "9 1 500 500 500 500 500 500 -1 1 ");
+    }
+
+    // Delta dumps see every cell written by chains.
+    {
+        std::mt19937 gen2(7);
+        program first = random_program(gen2, 6, 3000);
+        program second = random_program(gen2, 6, 3000);
+        Computer expected(128, ooasm::Backend::interpreter);
+        Computer computer(128, ooasm::Backend::parallel, 4);
+        for (program *p : {&first, &second, &lanes, &first}) {
+            std::stringstream a, b;
+            run(expected, *p);
+            run(computer, *p);
+            expected.memory_dump_delta(a);
+            computer.memory_dump_delta(b);
+            assert(a.str() == b.str());
+        }
+    }
+}
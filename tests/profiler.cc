@@ -0,0 +1,94 @@
+#include "computer.h"
+#include "ooasm.h"
+#include "profiler.h"
+#include <cassert>
+#include <exception>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+}
+
+int main() {
+    auto ooasm_sample = program({
+            data("a", num(5)),
+            data("pointer", num(3)),
+            inc(mem(num(3))),
+            inc(mem(num(3))),
+            add(mem(lea("a")), mem(mem(lea("pointer")))),
+            dec(mem(lea("a"))),
+            sub(mem(num(2)), num(1)),
+            mov(mem(num(4)), lea("a")),
+            ones(mem(num(5))),
+            onez(mem(num(5))),
+            one(mem(num(6)))
+    });
+
+    // Profiled boots leave memory as ordinary ones do, though the program is not optimized.
+    Computer expected(8), computer(8);
+    expected.boot(ooasm_sample);
+    ooasm::Profiler profiler(ooasm_sample, 4);
+    computer.boot(profiler);
+    assert(memory_dump(computer) == memory_dump(expected));
+    assert(profiler.bytecode().code.size() == 9);
+
+    // Increments merged by the optimizer are counted one by one.
+    computer.boot(profiler);
+    assert(profiler.executions(ooasm::element::data) == 4);
+    assert(profiler.executions(ooasm::element::inc) == 4);
+    assert(profiler.executions(ooasm::element::add) == 2);
+    assert(profiler.executions(ooasm::element::dec) == 2);
+    assert(profiler.executions(ooasm::element::sub) == 2);
+    assert(profiler.executions(ooasm::element::mov) == 2);
+    assert(profiler.executions(ooasm::element::ones) == 2);
+    assert(profiler.executions(ooasm::element::onez) == 2);
+    assert(profiler.executions(ooasm::element::one) == 2);
+
+    // Cell 3 is read twice by the increments, once through the pointer, and written twice.
+    const auto &cells = profiler.cells();
+    assert(cells.at(3).reads == 2 * 3 && cells.at(3).writes == 2 * 2);
+    assert(cells.at(0).reads == 2 * 2 && cells.at(0).writes == 2 * 3);
+    assert(cells.at(1).reads == 2 * 1 && cells.at(1).writes == 2 * 1);
+    assert(cells.at(6).reads == 0 && cells.at(6).writes == 2);
+    // Only one of the conditional writes happens.
+    assert(cells.at(5).reads == 0 && cells.at(5).writes == 2);
+
+    // Regions of four instructions, by position of the functions in the program.
+    auto regions = profiler.regions();
+    assert(regions.size() == 3);
+    assert(regions[0].first == 2 && regions[0].last == 6);
+    assert(regions[1].first == 6 && regions[1].last == 10);
+    assert(regions[2].first == 10 && regions[2].last == 11);
+    for (const auto &r : regions)
+        assert(r.seconds >= 0);
+
+    std::stringstream report;
+    profiler.report(report, 2);
+    assert(report.str().find("element=inc executed=4\n") != std::string::npos);
+    assert(report.str().find("cell=0 reads=4 writes=6\ncell=3 reads=6 writes=4\n") != std::string::npos);
+    assert(report.str().find("cell=1 ") == std::string::npos);
+
+    // A failing boot is profiled up to the failure.
+    auto ooasm_failing = program({
+            data("a", num(1)),
+            inc(mem(num(1))),
+            mov(mem(num(9)), num(1)),
+            inc(mem(num(1)))
+    });
+    ooasm::Profiler failing(ooasm_failing);
+    Computer small(4);
+    try {
+        small.boot(failing);
+        assert(false);
+    } catch (std::exception &e) {
+        assert(memory_dump(small) == "1 1 0 0 ");
+    }
+    assert(failing.executions(ooasm::element::inc) == 1);
+    assert(failing.executions(ooasm::element::mov) == 1);
+    assert(failing.cells().count(9) == 0);
+}
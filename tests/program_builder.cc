@@ -0,0 +1,63 @@
+#include "computer.h"
+#include "ooasm.h"
+#include "program_builder.h"
+#include <cassert>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+} // namespace
+
+int main() {
+    ooasm::ProgramBuilder b;
+    b.append(b.data("a", b.num(4)));
+    b.append(b.data("b", b.num(3)));
+    for (int i = 0; i < 1000; ++i)
+        b.append(b.inc(b.mem(b.lea("a"))));
+    b.append(b.sub(b.mem(b.lea("b")), b.mem(b.lea("a"))));
+    b.append(b.ones(b.mem(b.mem(b.num(2))))); // mem[0] is overwritten
+    b.append(b.mov(b.mem(b.num(3)), b.num(42)));
+    auto ooasm_built = b.build();
+
+    Computer computer1(4);
+    computer1.boot(ooasm_built);
+    assert(memory_dump(computer1) == "1 -1001 0 42 ");
+
+    b.append(b.one(b.mem(b.num(0))));
+    auto ooasm_rebuilt = b.build();
+
+    Computer computer2(2);
+    computer2.boot(ooasm_rebuilt);
+    assert(memory_dump(computer2) == "1 0 ");
+
+    ooasm_built = ooasm_rebuilt; // Releases the first arena after its instructions
+    computer2.boot(ooasm_built);
+    assert(memory_dump(computer2) == "1 0 ");
+
+    std::shared_ptr<ooasm::Num> survivor;
+    {
+        ooasm::ProgramBuilder b2;
+        survivor = b2.num(1);
+        b2.append(b2.mov(b2.mem(b2.num(0)), survivor));
+        program ooasm_scoped = b2.build();
+        computer2.boot(ooasm_scoped);
+        assert(memory_dump(computer2) == "1 0 ");
+    }
+    survivor.reset(); // An element outliving its program keeps the arena until released
+
+    // Elements stay valid, with their arena, as long as they are referenced.
+    std::shared_ptr<ooasm::Mem> cell = b.mem(b.num(0));
+    b.append(b.inc(cell));
+    {
+        program ooasm_dropped = b.build();
+    }
+    program ooasm_reused({mov(cell, num(7))});
+    computer2.boot(ooasm_reused);
+    assert(memory_dump(computer2) == "7 0 ");
+}
@@ -0,0 +1,140 @@
+#include "computer.h"
+#include "ooasm.h"
+#include "program_image.h"
+#include <cassert>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    void save(const char *path, const std::string &bytes) {
+        std::ofstream file(path, std::ios::binary);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    std::string image_of(const program &p) {
+        std::stringstream ss;
+        ooasm::write_program(ss, p);
+        return ss.str();
+    }
+
+    bool rejected(const char *path) {
+        try {
+            ooasm::MappedProgram mapped(path);
+        } catch (std::invalid_argument &e) {
+            return true;
+        }
+        return false;
+    }
+}
+
+int main() {
+    const char *path = "program_image_test.bin";
+
+    auto ooasm_sample = program({
+            data("a", num(5)),
+            data("pointer", num(4)),
+            mov(mem(num(2)), num(7)),
+            add(mem(num(2)), mem(lea("a"))),
+            sub(mem(mem(lea("pointer"))), num(3)),
+            dec(mem(lea("a"))),
+            onez(mem(num(3))),
+            ones(mem(num(5))),
+            data("a", num(1))
+    });
+    std::string bytes = image_of(ooasm_sample);
+    assert(bytes.compare(0, 8, "OOASMPG1") == 0);
+    assert(bytes.size() % 8 == 0);
+    save(path, bytes);
+
+    // A mapped image boots like the program it was written from, on either backend.
+    for (auto backend : {ooasm::Backend::interpreter, ooasm::Backend::jit}) {
+        for (int size : {3, 6, 8}) {
+            Computer original(size, backend), loaded(size, backend);
+            ooasm::MappedProgram mapped(path);
+            bool original_failed = false, loaded_failed = false;
+            try {
+                original.boot(ooasm_sample);
+            } catch (std::exception &e) {
+                original_failed = true;
+            }
+            try {
+                loaded.boot(mapped);
+            } catch (std::exception &e) {
+                loaded_failed = true;
+            }
+            assert(original_failed == loaded_failed && original_failed == (size < 6));
+            assert(memory_dump(original) == memory_dump(loaded));
+        }
+    }
+
+    {
+        ooasm::MappedProgram mapped(path, false);
+        assert(mapped.symbols() == 2);
+        assert(mapped.symbol(0) == "a" && mapped.symbol(1) == "pointer");
+        assert(mapped.bytecode().declarations.size() == 3);
+        assert(mapped.bytecode().code.size() == ooasm_sample.bytecode().code.size());
+
+        Computer computer(8);
+        computer.boot(mapped);
+        computer.boot(mapped);
+        assert(memory_dump(computer) == "4 4 12 0 -3 0 0 0 ");
+    }
+
+    // Identifiers never declared fail when the image boots, as they do in the program.
+    auto ooasm_unresolved = program({
+            data("a", num(1)),
+            mov(mem(lea("b")), num(2))
+    });
+    save(path, image_of(ooasm_unresolved));
+    {
+        ooasm::MappedProgram mapped(path);
+        Computer computer(4);
+        try {
+            computer.boot(mapped);
+            assert(false);
+        } catch (std::invalid_argument &e) {
+            assert(std::string(e.what()) == "Variable not found");
+        }
+    }
+
+    // Damaged images are not run.
+    save(path, "OOASMPG2" + bytes.substr(8));
+    assert(rejected(path));
+    save(path, bytes.substr(0, bytes.size() - 8));
+    assert(rejected(path));
+    save(path, bytes.substr(0, 20));
+    assert(rejected(path));
+
+    // Counts so large that the size of the sections wraps around are not trusted.
+    std::string huge = bytes.substr(0, 48) + std::string(4096 - 48, '\0');
+    for (std::size_t offset : {8, 16, 24}) {
+        for (int i = 0; i < 8; ++i)
+            huge[offset + i] = static_cast<char>(i == 7 ? 0x04 : 0);
+    }
+    save(path, huge);
+    assert(rejected(path));
+
+    // Reach lower than the static addresses of the code would skip their checks.
+    std::string lying = bytes;
+    std::size_t reach = 48 + 3 * 16 + ooasm_sample.bytecode().code.size() * 32;
+    lying[reach] = 1;
+    save(path, lying);
+    assert(rejected(path));
+
+    std::string bad_opcode = bytes;
+    bad_opcode[48 + 3 * 16 + 24] = 9;
+    save(path, bad_opcode);
+    assert(rejected(path));
+
+    std::remove(path);
+}
@@ -0,0 +1,55 @@
+#include "computer.h"
+#include "ooasm.h"
+#include <cassert>
+#include <exception>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    std::string zeros(int count) {
+        std::string s;
+        for (int i = 0; i < count; ++i)
+            s += "0 ";
+        return s;
+    }
+} // namespace
+
+int main() {
+    auto ooasm_sparse = program({
+            data("a", num(7)),
+            mov(mem(num(5000)), num(1)),
+            mov(mem(num(1)), num(4999)),
+            inc(mem(mem(num(1)))),
+            dec(mem(num(9999)))
+    });
+    auto ooasm_other = program({
+            mov(mem(num(600)), num(3)),
+            mov(mem(num(100)), num(2))
+    });
+    auto ooasm_mem_out_of_range = program({
+            mov(mem(num(700)), num(4)),
+            mov(mem(num(20000)), num(2))
+    });
+
+    Computer computer1(10000);
+    for (int i = 0; i < 3; ++i) {
+        computer1.boot(ooasm_sparse);
+        assert(memory_dump(computer1) == "7 4999 " + zeros(4997) + "1 1 " + zeros(4998) + "-1 ");
+
+        computer1.boot(ooasm_other);
+        assert(memory_dump(computer1) == zeros(100) + "2 " + zeros(499) + "3 " + zeros(9399));
+
+        try {
+            computer1.boot(ooasm_mem_out_of_range);
+            assert(false);
+        } catch (std::exception &e) {
+            assert(memory_dump(computer1) == zeros(700) + "4 " + zeros(9299));
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#include "computer.h"
+#include "memory_image.h"
+#include "ooasm.h"
+#include "result_cache.h"
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    program sample(int64_t step) {
+        return program{
+                data("a", num(5)),
+                data("p", num(3)),
+                add(mem(lea("a")), num(step)),
+                mov(mem(mem(lea("p"))), mem(lea("a"))),
+                sub(mem(num(2)), num(1)),
+                ones(mem(num(4)))
+        };
+    }
+}
+
+int main() {
+    // Programs that boot alike share a fingerprint, whatever their identifiers are.
+    assert(sample(2).fingerprint() == sample(2).fingerprint());
+    assert(sample(2).fingerprint() != sample(3).fingerprint());
+    program renamed = {
+            data("b", num(5)),
+            data("q", num(3)),
+            add(mem(lea("b")), num(2)),
+            mov(mem(mem(lea("q"))), mem(lea("b"))),
+            sub(mem(num(2)), num(1)),
+            ones(mem(num(4)))
+    };
+    assert(renamed.fingerprint() == sample(2).fingerprint());
+    program other = {data("a", num(5)), add(mem(lea("a")), mem(num(0)))};
+    program another = {data("a", num(5)), add(mem(lea("a")), num(0))};
+    assert(other.fingerprint() != another.fingerprint());
+
+    // Repeated boots hit, memory of another size misses.
+    ooasm::ResultCache cache;
+    program p = sample(2);
+    Computer computer(6);
+    for (int i = 0; i < 3; ++i) {
+        computer.boot(p, cache);
+        assert(memory_dump(computer) == "7 3 -1 7 1 0 ");
+    }
+    assert(cache.misses() == 1 && cache.hits() == 2 && cache.size() == 1);
+
+    Computer same(6), larger(8);
+    program copy = sample(2);
+    same.boot(copy, cache);
+    assert(memory_dump(same) == "7 3 -1 7 1 0 ");
+    larger.boot(p, cache);
+    assert(memory_dump(larger) == "7 3 -1 7 1 0 0 0 ");
+    assert(cache.misses() == 2 && cache.hits() == 3 && cache.size() == 2);
+
+    // Failures are kept with the memory they left.
+    Computer small(3);
+    for (int i = 0; i < 2; ++i) {
+        try {
+            small.boot(p, cache);
+            assert(false);
+        } catch (std::invalid_argument &e) {
+            assert(std::string(e.what()) == "Out of bounds");
+            assert(memory_dump(small) == "7 3 0 ");
+        }
+    }
+    assert(cache.misses() == 3 && cache.hits() == 4);
+
+    // A hit replaces whatever the previous boot left, and delta dumps follow it.
+    Computer tracked(6);
+    std::stringstream full, delta;
+    program nine = sample(9);
+    tracked.boot(nine, cache);
+    tracked.memory_dump_delta(full);
+    tracked.boot(p, cache);
+    assert(memory_dump(tracked) == "7 3 -1 7 1 0 ");
+    tracked.memory_dump_delta(delta);
+    ooasm::MemoryDelta changes = ooasm::read_delta(delta);
+    assert(!changes.full && changes.changes.size() == 2);
+
+    std::stringstream report;
+    cache.report(report);
+    assert(report.str().rfind("cache_hits=5 cache_misses=4 cache_evictions=0 cache_results=4", 0) == 0);
+
+    // The least recently used results go first once the cache is full.
+    ooasm::ResultCache tiny(12);
+    Computer c(6);
+    program first = sample(1), second = sample(2), third = sample(3);
+    c.boot(first, tiny);
+    c.boot(second, tiny);
+    c.boot(first, tiny);
+    c.boot(third, tiny);
+    assert(tiny.evictions() == 1 && tiny.size() == 2);
+    c.boot(first, tiny);
+    assert(tiny.hits() == 2);
+    c.boot(second, tiny);
+    assert(tiny.hits() == 2 && tiny.misses() == 4);
+    assert(memory_dump(c) == "7 3 -1 7 1 0 ");
+
+    // Results larger than the whole cache are not kept.
+    ooasm::ResultCache none(2);
+    c.boot(first, none);
+    c.boot(first, none);
+    assert(none.hits() == 0 && none.size() == 0);
+}
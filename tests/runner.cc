@@ -0,0 +1,64 @@
+#include "computer.h"
+#include "ooasm.h"
+#include "runner.h"
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string memory_dump(const std::vector<int64_t> &memory) {
+        std::stringstream ss;
+        for (auto a : memory)
+            ss << a << ' ';
+        return ss.str();
+    }
+} // namespace
+
+int main() {
+    auto ooasm_operations = std::make_shared<const program>(program({
+            data("a", num(4)),
+            data("b", num(3)),
+            add(mem(lea("a")), mem(lea("b"))),
+            dec(mem(lea("b"))),
+            ones(mem(num(2)))
+    }));
+    auto ooasm_mem_out_of_range = std::make_shared<const program>(program({
+            mov(mem(num(1)), num(2)),
+            mov(mem(num(100)), num(2))
+    }));
+
+    std::vector<std::future<ooasm::RunResult>> results;
+    std::atomic<int> done{0};
+    {
+        ooasm::Runner runner(4);
+        for (int i = 0; i < 200; ++i)
+            results.push_back(runner.submit(i % 2 ? ooasm_operations : ooasm_mem_out_of_range, 3 + i % 3));
+
+        for (int i = 0; i < 100; ++i)
+            runner.submit(ooasm_operations, 3, [&done](ooasm::RunResult &&r) {
+                if (r.error == nullptr && memory_dump(r.memory) == "7 2 0 ")
+                    ++done;
+            });
+    } // Waits for all jobs
+
+    assert(done == 100);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        auto r = results[i].get();
+        std::string zeros;
+        for (std::size_t k = 0; k < i % 3; ++k)
+            zeros += "0 ";
+
+        if (i % 2) {
+            assert(r.error == nullptr);
+            assert(memory_dump(r.memory) == "7 2 0 " + zeros);
+        } else {
+            assert(r.error != nullptr);
+            assert(memory_dump(r.memory) == "0 2 0 " + zeros);
+        }
+    }
+}
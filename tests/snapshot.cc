@@ -0,0 +1,203 @@
+#include "computer.h"
+#include "computer_memory.h"
+#include "interpreter.h"
+#include "memory_image.h"
+#include "ooasm.h"
+#include "snapshot.h"
+#include <cassert>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    using elements_t = std::vector<std::shared_ptr<ooasm::Function>>;
+
+    const elements_t declarations = {data("a", num(3)), data("p", num(40000)), data("n", num(-2))};
+
+    // Instructions over cells spread across the pages of 70000 cells, some through
+    // the pointer p, some reading or setting flags.
+    elements_t random_tail(std::mt19937 &gen, int length) {
+        std::uniform_int_distribution<int> pick(0, 99);
+        auto lvalue = [&]() -> std::shared_ptr<ooasm::Mem> {
+            int choice = pick(gen);
+            if (choice < 50)
+                return mem(num(3 + (pick(gen) * 7919 + pick(gen)) % 69990));
+            if (choice < 80)
+                return mem(lea(choice < 70 ? "a" : "n"));
+            return mem(mem(lea("p")));
+        };
+
+        elements_t tail;
+        for (int i = 0; i < length; ++i) {
+            switch (pick(gen) % 6) {
+                case 0:
+                    tail.push_back(mov(lvalue(), num(pick(gen) - 50)));
+                    break;
+                case 1:
+                    tail.push_back(add(lvalue(), lvalue()));
+                    break;
+                case 2:
+                    tail.push_back(sub(lvalue(), num(pick(gen))));
+                    break;
+                case 3:
+                    tail.push_back(inc(lvalue()));
+                    break;
+                case 4:
+                    tail.push_back(ones(lvalue()));
+                    break;
+                default:
+                    tail.push_back(onez(lvalue()));
+            }
+        }
+        return tail;
+    }
+
+    elements_t concat(std::initializer_list<const elements_t *> parts) {
+        elements_t all;
+        for (const elements_t *part : parts)
+            all.insert(all.end(), part->begin(), part->end());
+        return all;
+    }
+
+    // Memory left by booting the declarations followed by [parts].
+    std::string expected(std::initializer_list<const elements_t *> parts) {
+        program whole(concat(parts));
+        Computer computer(70000, ooasm::Backend::interpreter);
+        computer.boot(whole);
+        return memory_dump(computer);
+    }
+}
+
+int main() {
+    // Tails resumed from snapshots leave what the whole program leaves, however the
+    // computer running them got to the snapshot.
+    std::mt19937 gen(24);
+    elements_t prefix = random_tail(gen, 300);
+    program head(concat({&declarations, &prefix}));
+    Computer computer(70000);
+    computer.boot(head);
+    ooasm::Snapshot start = computer.snapshot();
+    assert(start.size() == 70000 && start.pages() > 0);
+
+    Computer forked(16);
+    for (int round = 0; round < 40; ++round) {
+        elements_t tail = random_tail(gen, 1 + round % 30);
+        program resumed(concat({&declarations, &tail}));
+        std::string result = expected({&declarations, &prefix, &tail});
+
+        computer.restore(start);
+        computer.resume(resumed);
+        assert(memory_dump(computer) == result);
+
+        forked.restore(start);
+        forked.resume(resumed);
+        assert(memory_dump(forked) == result);
+
+        // Snapshots taken from snapshots share what neither wrote.
+        ooasm::Snapshot middle = computer.snapshot();
+        elements_t more = random_tail(gen, 5);
+        program further(concat({&declarations, &more}));
+        computer.resume(further);
+        assert(memory_dump(computer) == expected({&declarations, &prefix, &tail, &more}));
+        forked.restore(middle);
+        assert(memory_dump(forked) == result);
+        forked.resume(further);
+        assert(memory_dump(forked) == memory_dump(computer));
+    }
+
+    // Boots in between start over from zeroed memory.
+    program other = {data("x", num(9)), mov(mem(num(65000)), num(4)), dec(mem(lea("x")))};
+    computer.boot(other);
+    computer.restore(start);
+    assert(memory_dump(computer) == expected({&declarations, &prefix}));
+    computer.resume(other);
+    Computer alone(70000, ooasm::Backend::interpreter);
+    alone.boot(head);
+    alone.resume(other);
+    assert(memory_dump(computer) == memory_dump(alone));
+
+    // Flags and variables declared past the snapshot come back as they were.
+    Computer small(8);
+    program flags = {data("a", num(1)), sub(mem(lea("a")), num(1))};
+    small.boot(flags);
+    ooasm::Snapshot zero = small.snapshot();
+    program tail = {data("a", num(1)), data("b", num(5)), onez(mem(num(3))), ones(mem(num(4)))};
+    for (int i = 0; i < 2; ++i) {
+        small.resume(tail);
+        assert(memory_dump(small) == "0 5 0 1 0 0 0 0 ");
+        small.restore(zero);
+        assert(memory_dump(small) == "0 0 0 0 0 0 0 0 ");
+    }
+    program overflow = {data("a", num(1)), data("b", num(1)), data("c", num(1)), data("d", num(1)),
+                        data("e", num(1)), data("f", num(1)), data("g", num(1)), data("h", num(1)),
+                        data("i", num(1))};
+    try {
+        small.resume(overflow);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+        assert(std::string(e.what()) == "Too many variables");
+    }
+
+    // Tails find the variables of the prefix by identifier, in any order or subset,
+    // whether it was booted, streamed, resumed or restored.
+    program named_prefix = {data("a", num(5)), data("b", num(9))};
+    program reordered = {data("b", num(0)), inc(mem(lea("b")))};
+    program subset = {data("c", num(7)), data("a", num(0)), add(mem(lea("a")), mem(lea("c"))),
+                      dec(mem(lea("b")))};
+    Computer linked(4);
+    linked.boot(named_prefix);
+    linked.resume(reordered);
+    assert(memory_dump(linked) == "5 10 0 0 ");
+    ooasm::Snapshot resumed = linked.snapshot();
+    linked.resume(subset);
+    assert(memory_dump(linked) == "12 9 7 0 ");
+    linked.restore(resumed);
+    linked.resume(reordered);
+    assert(memory_dump(linked) == "5 11 0 0 ");
+    elements_t streamed = {data("b", num(9)), data("a", num(5))};
+    linked.boot_stream(streamed.begin(), streamed.end());
+    linked.resume(reordered);
+    assert(memory_dump(linked) == "10 5 0 0 ");
+
+    program unknown = {data("a", num(0)), inc(mem(lea("z")))};
+    linked.boot(named_prefix);
+    try {
+        linked.resume(unknown);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+        assert(std::string(e.what()) == "Variable not found");
+    }
+
+    ooasm::ComputerMemory cm;
+    cm.size = 4;
+    cm.setup();
+    cm.store(cm.add("x")) = 7;
+    ooasm::Snapshot named = ooasm::Snapshot::take(cm);
+    cm.setup();
+    named.restore(cm);
+    assert(cm.idx("x") == 0 && cm.mem[0] == 7 && cm.last_index == 1);
+
+    // Delta dumps see cells rewritten by restores.
+    Computer tracked(8);
+    std::stringstream first, second, third;
+    tracked.restore(zero);
+    tracked.memory_dump_delta(first);
+    tracked.resume(tail);
+    tracked.restore(zero);
+    tracked.memory_dump_delta(second);
+    ooasm::MemoryDelta delta = ooasm::read_delta(second);
+    assert(!delta.full && delta.changes.empty());
+    tracked.resume(tail);
+    tracked.memory_dump_delta(third);
+    delta = ooasm::read_delta(third);
+    assert(!delta.full && delta.changes.size() == 2);
+}
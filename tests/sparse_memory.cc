@@ -0,0 +1,58 @@
+#include "computer_memory.h"
+#include "interpreter.h"
+#include "ooasm.h"
+#include "storage.h"
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <sys/resource.h>
+
+namespace {
+    long peak_rss_kb() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+} // namespace
+
+int main() {
+    auto ooasm_far = program({
+            data("a", num(3)),
+            mov(mem(num(4294967295)), num(7)),
+            mov(mem(num(2147483648)), mem(lea("a"))),
+            add(mem(mem(num(2147483648))), num(5))
+    });
+
+    // 2^32 cells are 32 GiB, of which only the touched pages are committed.
+    ooasm::ComputerMemory cm;
+    cm.size = uint64_t(1) << 32;
+    for (int i = 0; i < 3; ++i) {
+        cm.setup();
+        ooasm::Interpreter(ooasm_far.bytecode(), cm).run();
+
+        assert(cm.mem.size() == cm.size);
+        assert(cm.mem[0] == 3 && cm.mem[3] == 5 && cm.mem[4] == 0);
+        assert(cm.mem[2147483648] == 3);
+        assert(cm.mem[4294967295] == 7);
+    }
+
+    // Clearing a mapping at the same size gives its pages back instead of touching them.
+    ooasm::Storage<int64_t> cells(uint64_t(1) << 32);
+    cells[0] = 1;
+    cells[4294967295] = 2;
+    cells.assign(cells.size(), 0);
+    assert(cells.size() == uint64_t(1) << 32 && cells[0] == 0 && cells[4294967295] == 0);
+    cells[12345] = 3;
+    cells.assign(cells.size(), 0);
+    assert(cells[12345] == 0);
+
+    // Sizes whose bytes do not fit in size_t are rejected instead of wrapping around.
+    try {
+        cells.assign(SIZE_MAX / 4, 0);
+        assert(false);
+    } catch (std::bad_alloc &e) {
+    }
+    assert(cells.size() == 0);
+
+    assert(peak_rss_kb() < 256 * 1024);
+}
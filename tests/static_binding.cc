@@ -0,0 +1,77 @@
+#include "computer.h"
+#include "linker.h"
+#include "ooasm.h"
+#include <cassert>
+#include <exception>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+} // namespace
+
+int main() {
+    auto ooasm_static = program({
+            data("a", num(2)),
+            data("b", num(0)),
+            mov(mem(lea("b")), num(3)),
+            add(mem(num(2)), mem(lea("b"))),
+            mov(mem(num(4)), mem(mem(num(2)))),
+            inc(mem(num(6)))
+    });
+    const auto &bc = ooasm_static.bytecode();
+    assert(ooasm::Linker::bound(bc, 7) == bc.code.size());
+    assert(ooasm::Linker::bound(bc, 6) == bc.code.size() - 1);
+    assert(ooasm::Linker::bound(bc, 2) == 1);
+    assert(ooasm::Linker::bound(bc, 1) == 0);
+
+    Computer computer1(7);
+    computer1.boot(ooasm_static);
+    assert(memory_dump(computer1) == "2 3 3 0 0 0 1 ");
+
+    // Instructions before the first static address past the memory run,
+    // the failing one leaves memory untouched.
+    Computer computer2(5);
+    try {
+        computer2.boot(ooasm_static);
+        assert(false);
+    } catch (std::exception &e) {
+        assert(memory_dump(computer2) == "2 3 3 0 0 ");
+    }
+
+    // Dynamic addresses are still checked within the bound part of the code.
+    auto ooasm_dynamic = program({
+            data("p", num(9)),
+            mov(mem(num(1)), num(1)),
+            mov(mem(mem(lea("p"))), num(5)),
+            mov(mem(num(1)), num(2))
+    });
+    Computer computer3(4);
+    try {
+        computer3.boot(ooasm_dynamic);
+        assert(false);
+    } catch (std::exception &e) {
+        assert(memory_dump(computer3) == "9 1 0 0 ");
+    }
+
+    // A conditional write past the memory fails only when it happens.
+    auto ooasm_conditional = program({
+            data("a", num(1)),
+            dec(mem(lea("a"))),
+            ones(mem(num(10))),
+            inc(mem(num(1))),
+            dec(mem(num(1))),
+            onez(mem(num(10)))
+    });
+    Computer computer4(2);
+    try {
+        computer4.boot(ooasm_conditional);
+        assert(false);
+    } catch (std::exception &e) {
+        assert(memory_dump(computer4) == "0 0 ");
+    }
+}
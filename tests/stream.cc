@@ -0,0 +1,130 @@
+#include "computer.h"
+#include "ooasm.h"
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    std::vector<std::shared_ptr<ooasm::Function>> sample() {
+        return {
+                data("a", num(5)),
+                data("pointer", num(3)),
+                data("a", num(9)),
+                mov(mem(num(4)), num(7)),
+                add(mem(num(4)), mem(lea("a"))),
+                sub(mem(mem(lea("pointer"))), num(3)),
+                dec(mem(lea("a"))),
+                onez(mem(num(5))),
+                ones(mem(num(6))),
+                sub(mem(num(5)), num(1)),
+                ones(mem(num(6)))
+        };
+    }
+}
+
+int main() {
+    auto elements = sample();
+    auto ooasm_sample = program(sample());
+
+    // Any chunk size boots like the whole program, flags carry over between chunks.
+    Computer expected(8);
+    expected.boot(ooasm_sample);
+    for (std::size_t chunk : {1, 2, 3, 5, 100}) {
+        Computer computer(8);
+        computer.boot_stream(elements.begin(), elements.end(), chunk);
+        assert(memory_dump(computer) == memory_dump(expected));
+        assert(memory_dump(computer) == "4 3 9 -3 12 -1 1 0 ");
+    }
+
+    // A long generated program, holding only a chunk of it at a time.
+    const int64_t length = 200000;
+    int64_t produced = 0;
+    std::weak_ptr<ooasm::Function> first;
+    Computer computer1(4);
+    computer1.boot_stream([&]() -> std::shared_ptr<ooasm::Function> {
+        if (produced == 2 * int64_t(ooasm::Stream::default_chunk))
+            assert(first.expired());
+        if (produced == length)
+            return nullptr;
+
+        std::shared_ptr<ooasm::Function> element;
+        if (produced == 0)
+            element = data("step", num(2));
+        else
+            element = add(mem(num(1 + produced % 3)), mem(lea("step")));
+        if (produced++ == 1)
+            first = element;
+        return element;
+    });
+    assert(memory_dump(computer1) == "2 133332 133334 133332 ");
+
+    // Declarations after the first instruction cannot be placed anymore.
+    std::vector<std::shared_ptr<ooasm::Function>> late = {
+            data("a", num(1)),
+            mov(mem(num(1)), num(2)),
+            data("b", num(3)),
+            mov(mem(num(2)), num(4))
+    };
+    for (std::size_t chunk : {1, 4}) {
+        Computer computer(4);
+        try {
+            computer.boot_stream(late.begin(), late.end(), chunk);
+            assert(false);
+        } catch (std::invalid_argument &e) {
+            assert(std::string(e.what()) == "Declaration after code");
+        }
+    }
+
+    // Undeclared identifiers fail once their chunk is reached.
+    std::vector<std::shared_ptr<ooasm::Function>> undeclared = {
+            data("a", num(1)),
+            mov(mem(num(1)), num(2)),
+            mov(mem(lea("b")), num(4))
+    };
+    Computer computer2(3);
+    try {
+        computer2.boot_stream(undeclared.begin(), undeclared.end(), 1);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+        assert(std::string(e.what()) == "Variable not found");
+        assert(memory_dump(computer2) == "1 2 0 ");
+    }
+
+    // Out of bounds and too many variables fail as they do in a whole program.
+    std::vector<std::shared_ptr<ooasm::Function>> failing = {
+            mov(mem(num(1)), num(2)),
+            mov(mem(num(3)), num(4))
+    };
+    try {
+        computer2.boot_stream(failing.begin(), failing.end());
+        assert(false);
+    } catch (std::invalid_argument &e) {
+        assert(std::string(e.what()) == "Out of bounds");
+        assert(memory_dump(computer2) == "0 2 0 ");
+    }
+
+    std::vector<std::shared_ptr<ooasm::Function>> crowded = {
+            data("a", num(1)), data("b", num(1)), data("c", num(1)), data("d", num(1))
+    };
+    try {
+        computer2.boot_stream(crowded.begin(), crowded.end(), 2);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+        assert(std::string(e.what()) == "Too many variables");
+    }
+
+    // Rebooting starts over from empty memory.
+    computer2.boot_stream(elements.begin(), elements.begin() + 3);
+    assert(memory_dump(computer2) == "5 3 9 ");
+}
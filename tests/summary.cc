@@ -0,0 +1,165 @@
+#include "computer.h"
+#include "interpreter.h"
+#include "ooasm.h"
+#include "summary.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    // Memory after the declarations, with declared cells then set to [inputs].
+    ooasm::ComputerMemory declared(const ooasm::BytecodeView &bc, ooasm::ComputerMemory::vars_size_t size,
+                                   const std::vector<int64_t> &inputs) {
+        ooasm::ComputerMemory cm;
+        cm.size = size;
+        cm.setup();
+        ooasm::Interpreter(bc, cm).declare();
+        for (std::size_t i = 0; i < inputs.size(); ++i)
+            cm.mem[i] = inputs[i];
+        return cm;
+    }
+
+    // Static code on 12 cells, the first four declared, with conditional writes only
+    // to cells read by no later instruction.
+    program random_program(std::mt19937 &gen, int length) {
+        std::uniform_int_distribution<int> pick(0, 99);
+        auto operand = [&]() -> std::shared_ptr<ooasm::RValue> {
+            if (pick(gen) % 3)
+                return mem(num(pick(gen) % 10));
+            return num(pick(gen) - 50);
+        };
+
+        std::vector<std::shared_ptr<ooasm::Function>> code;
+        for (const char *name : {"a", "b", "c", "d"})
+            code.push_back(data(name, num(pick(gen) - 50)));
+        for (int i = 0; i < length; ++i) {
+            auto dst = mem(num(pick(gen) % 10));
+            int choice = pick(gen);
+            if (choice < 30)
+                code.push_back(add(dst, operand()));
+            else if (choice < 55)
+                code.push_back(sub(dst, operand()));
+            else if (choice < 75)
+                code.push_back(mov(dst, operand()));
+            else if (choice < 80)
+                code.push_back(inc(dst));
+            else if (choice < 85)
+                code.push_back(dec(dst));
+            else if (choice < 90)
+                code.push_back(one(dst));
+            else if (choice < 95)
+                code.push_back(ones(mem(num(10 + pick(gen) % 2))));
+            else
+                code.push_back(onez(mem(num(10 + pick(gen) % 2))));
+        }
+        return program(std::move(code));
+    }
+}
+
+int main() {
+    // Summaries give what the interpreter gives, for any values of the variables.
+    std::mt19937 gen(21);
+    int summarized = 0;
+    for (int round = 0; round < 300; ++round) {
+        program p = random_program(gen, 20 + round % 40);
+        std::unique_ptr<ooasm::Summary> summary = ooasm::Summary::build(p.bytecode());
+        if (summary == nullptr)
+            continue;
+        ++summarized;
+        assert(summary->cost() < p.bytecode().code.size());
+
+        for (int trial = 0; trial < 10; ++trial) {
+            std::vector<int64_t> inputs;
+            for (int i = 0; i < 4; ++i) {
+                int choice = static_cast<int>(gen() % 4);
+                inputs.push_back(choice == 0 ? 0 : choice == 1 ? int64_t(gen() % 7) - 3
+                                                               : static_cast<int64_t>(uint64_t(gen()) << 33 | gen()));
+            }
+            ooasm::ComputerMemory expected = declared(p.bytecode(), 12, inputs);
+            ooasm::ComputerMemory cm = expected;
+            ooasm::Interpreter(p.bytecode(), expected).execute();
+            assert(summary->apply(cm));
+            assert(std::equal(cm.mem.begin(), cm.mem.end(), expected.mem.begin()));
+            assert(cm.last_result == expected.last_result);
+        }
+    }
+    assert(summarized > 100);
+
+    // Computers summarize programs from the second boot on, unless they run the JIT.
+    std::vector<std::shared_ptr<ooasm::Function>> elements = {data("n", num(5)), data("m", num(-7))};
+    for (int i = 0; i < 100; ++i) {
+        elements.push_back(add(mem(num(2)), mem(lea("n"))));
+        elements.push_back(sub(mem(num(3)), mem(lea("m"))));
+        elements.push_back(add(mem(num(6)), mem(num(2))));
+    }
+    elements.push_back(sub(mem(num(3)), num(700)));
+    elements.push_back(onez(mem(num(4))));
+    elements.push_back(ones(mem(num(5))));
+    elements.push_back(mov(mem(num(7)), mem(num(3))));
+    program counters(std::move(elements));
+
+    Computer computer(8, ooasm::Backend::interpreter);
+    computer.boot(counters);
+    assert(memory_dump(computer) == "5 -7 500 0 1 0 25250 0 ");
+    assert(counters.backend_cache().get<ooasm::SummarizedProgram>().get(counters.bytecode()) != nullptr);
+    for (int i = 0; i < 3; ++i) {
+        computer.boot(counters);
+        assert(memory_dump(computer) == "5 -7 500 0 1 0 25250 0 ");
+    }
+
+    // Memory too small for the program fails as executing it does.
+    Computer small(6, ooasm::Backend::interpreter);
+    for (int i = 0; i < 2; ++i) {
+        try {
+            small.boot(counters);
+            assert(false);
+        } catch (std::invalid_argument &e) {
+            assert(std::string(e.what()) == "Out of bounds");
+            assert(memory_dump(small) == "5 -7 5 7 0 0 ");
+        }
+    }
+
+    // Programs writing through pointers and programs reading cells written under a
+    // guard have no summary.
+    program pointers = {
+            data("p", num(3)),
+            inc(mem(num(2))), inc(mem(num(2))), inc(mem(num(2))),
+            inc(mem(mem(lea("p"))))
+    };
+    program guarded = {
+            data("n", num(1)),
+            sub(mem(num(1)), mem(lea("n"))), sub(mem(num(1)), mem(lea("n"))),
+            onez(mem(num(2))),
+            add(mem(num(3)), mem(num(2))), inc(mem(num(3))), inc(mem(num(3)))
+    };
+    for (program *p : {&pointers, &guarded}) {
+        Computer c(8, ooasm::Backend::interpreter);
+        c.boot(*p);
+        c.boot(*p);
+        assert(p->backend_cache().get<ooasm::SummarizedProgram>().get(p->bytecode()) == nullptr);
+    }
+
+    // Delta dumps see cells written by summaries.
+    Computer tracked(8, ooasm::Backend::interpreter);
+    std::stringstream first, second;
+    tracked.boot(counters);
+    tracked.memory_dump_delta(first);
+    tracked.boot(pointers);
+    tracked.boot(counters);
+    tracked.memory_dump_delta(second);
+    ooasm::MemoryDelta delta = ooasm::read_delta(second);
+    assert(!delta.full && delta.changes.empty());
+}
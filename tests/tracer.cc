@@ -0,0 +1,113 @@
+#include "computer.h"
+#include "ooasm.h"
+#include "tracer.h"
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::string memory_dump(Computer const &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    ooasm::Trace round_trip(const ooasm::Tracer &tracer) {
+        std::stringstream ss;
+        tracer.flush(ss);
+        return ooasm::read_trace(ss);
+    }
+}
+
+int main() {
+    auto ooasm_sample = program({
+            data("a", num(5)),
+            inc(mem(num(2))),
+            data("pointer", num(3)),
+            inc(mem(num(2))),
+            sub(mem(mem(lea("pointer"))), mem(lea("a"))),
+            onez(mem(num(4))),
+            ones(mem(num(4))),
+            add(mem(num(2)), num(-2))
+    });
+
+    Computer expected(5), computer(5);
+    expected.boot(ooasm_sample);
+    ooasm::Tracer tracer(ooasm_sample, 16);
+    computer.boot(tracer);
+    assert(memory_dump(computer) == memory_dump(expected));
+
+    ooasm::Trace trace = round_trip(tracer);
+    assert(trace.first == 0 && trace.records.size() == 6);
+    const auto &r = trace.records;
+    using ooasm::TraceRecord;
+    assert(r[0].position == 1 && r[0].address == 2 && r[0].before == 0 && r[0].after == 1);
+    assert(r[0].flags == TraceRecord::wrote);
+    assert(r[1].position == 3 && r[1].before == 1 && r[1].after == 2);
+    assert(r[2].position == 4 && r[2].address == 3 && r[2].before == 0 && r[2].after == -5);
+    assert(r[2].flags == (TraceRecord::wrote | TraceRecord::sign));
+    // onez() is not taken, ones() is.
+    assert(r[3].position == 5 && r[3].flags == TraceRecord::sign);
+    assert(r[4].position == 6 && r[4].address == 4 && r[4].after == 1);
+    assert(r[5].position == 7 && r[5].after == 0);
+    assert(r[5].flags == (TraceRecord::wrote | TraceRecord::zero));
+
+    // The buffer keeps the last records of all boots.
+    for (int i = 0; i < 3; ++i)
+        computer.boot(tracer);
+    assert(tracer.recorded() == 24);
+    trace = round_trip(tracer);
+    assert(trace.first == 8 && trace.records.size() == 16);
+    assert(trace.records[0].position == 4 && trace.records.back().position == 7);
+
+    // A failing boot is traced up to the failure.
+    auto ooasm_failing = program({
+            data("p", num(9)),
+            inc(mem(num(1))),
+            mov(mem(mem(lea("p"))), num(1))
+    });
+    ooasm::Tracer failing(ooasm_failing);
+    Computer small(3);
+    try {
+        small.boot(failing);
+        assert(false);
+    } catch (std::exception &e) {
+    }
+    trace = round_trip(failing);
+    assert(trace.records.size() == 1 && trace.records[0].position == 1);
+
+    // Flushing while boots run only ever yields whole records, in order.
+    std::vector<std::shared_ptr<ooasm::Function>> code;
+    for (int i = 0; i < 1000; ++i)
+        code.push_back(add(mem(num(i % 7)), num(1)));
+    program ooasm_long(std::move(code));
+    ooasm::Tracer busy(ooasm_long, 256);
+    std::atomic<bool> done{false};
+    std::thread booting([&] {
+        Computer c(8);
+        for (int i = 0; i < 200; ++i)
+            c.boot(busy);
+        done = true;
+    });
+    while (!done) {
+        trace = round_trip(busy);
+        assert(trace.records.size() <= 256);
+        for (std::size_t i = 0; i < trace.records.size(); ++i) {
+            const auto &record = trace.records[i];
+            assert(record.position == (trace.first + i) % 1000);
+            assert(record.address == record.position % 7 && record.after == record.before + 1);
+        }
+    }
+    booting.join();
+
+    std::stringstream garbage("OOASMEM1 and more");
+    try {
+        ooasm::read_trace(garbage);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+    }
+}
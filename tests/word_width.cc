@@ -0,0 +1,196 @@
+#include "batch.h"
+#include "computer.h"
+#include "computer_memory.h"
+#include "interpreter.h"
+#include "linker.h"
+#include "ooasm.h"
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    template<typename Word>
+    std::string memory_dump(const BasicComputer<Word> &computer) {
+        std::stringstream ss;
+        computer.memory_dump(ss);
+        return ss.str();
+    }
+
+    template<typename Word>
+    std::string run(BasicComputer<Word> &computer, program &p) {
+        try {
+            computer.boot(p);
+        } catch (std::exception &e) {
+            return std::string(e.what()) + ": " + memory_dump(computer);
+        }
+        return memory_dump(computer);
+    }
+
+    // Memory left by interpreting the program as lowered, without the optimizer.
+    template<typename Word>
+    std::string lowered(const program &p, ooasm::ComputerMemory::vars_size_t size) {
+        ooasm::Bytecode bc = p.lower();
+        ooasm::Linker::bind(bc);
+        ooasm::BasicComputerMemory<Word> cm;
+        cm.size = size;
+        cm.setup();
+        std::string error;
+        try {
+            ooasm::Interpreter(bc, cm).run();
+        } catch (std::exception &e) {
+            error = std::string(e.what()) + ": ";
+        }
+        std::stringstream ss;
+        ooasm::write_text(ss, cm.mem.begin(), cm.mem.end());
+        return error + ss.str();
+    }
+
+    // Programs over 16 cells with values around the limits of narrow words, pointers
+    // and flags.
+    program random_program(std::mt19937 &gen, int length) {
+        std::uniform_int_distribution<int> pick(0, 99);
+        const int64_t limits[] = {0, 1, -1, 32767, -32768, 65535, 65536, 2147483647, -2147483648LL, 70000};
+        auto literal = [&]() {
+            return limits[pick(gen) % 10] + pick(gen) % 3 - 1;
+        };
+        auto lvalue = [&]() -> std::shared_ptr<ooasm::Mem> {
+            int choice = pick(gen);
+            if (choice < 70)
+                return mem(num(2 + pick(gen) % 14));
+            if (choice < 90)
+                return mem(lea(choice < 80 ? "a" : "b"));
+            return mem(mem(num(pick(gen) % 4)));
+        };
+        auto rvalue = [&]() -> std::shared_ptr<ooasm::RValue> {
+            if (pick(gen) % 2)
+                return num(literal());
+            return lvalue();
+        };
+
+        std::vector<std::shared_ptr<ooasm::Function>> code = {data("a", num(literal())), data("b", num(3))};
+        for (int i = 0; i < length; ++i) {
+            switch (pick(gen) % 7) {
+                case 0:
+                    code.push_back(mov(lvalue(), rvalue()));
+                    break;
+                case 1:
+                case 2:
+                    code.push_back(add(lvalue(), rvalue()));
+                    break;
+                case 3:
+                    code.push_back(sub(lvalue(), rvalue()));
+                    break;
+                case 4:
+                    code.push_back(inc(lvalue()));
+                    break;
+                case 5:
+                    code.push_back(ones(lvalue()));
+                    break;
+                default:
+                    code.push_back(onez(lvalue()));
+            }
+        }
+        return program(std::move(code));
+    }
+}
+
+int main() {
+    // Narrow words wrap around at their own width, and so do literals and declarations.
+    program limits = {
+            data("a", num(32767)),
+            data("b", num(70000)),
+            inc(mem(lea("a"))),
+            ones(mem(num(2))),
+            sub(mem(num(3)), num(65536)),
+            onez(mem(num(4))),
+            mov(mem(num(5)), num(-1))
+    };
+    BasicComputer<int16_t> computer16(6);
+    BasicComputer<int32_t> computer32(6);
+    Computer computer64(6);
+    computer16.boot(limits);
+    computer32.boot(limits);
+    computer64.boot(limits);
+    assert(memory_dump(computer16) == "-32768 4464 1 0 1 -1 ");
+    assert(memory_dump(computer32) == "32768 70000 0 -65536 0 -1 ");
+    assert(memory_dump(computer64) == "32768 70000 0 -65536 0 -1 ");
+
+    // Addresses read from cells are sign-extended, static addresses are not bounded.
+    program pointers = {data("p", num(65538)), mov(mem(mem(lea("p"))), num(7)), mov(mem(num(70000)), num(1))};
+    BasicComputer<int16_t> far16(70001);
+    far16.boot(pointers);
+    std::stringstream far;
+    far16.memory_dump(far);
+    assert(far.str().rfind("2 0 7 ", 0) == 0);
+    program negative = {data("p", num(65535)), mov(mem(mem(lea("p"))), num(7))};
+    try {
+        far16.boot(negative);
+        assert(false);
+    } catch (std::invalid_argument &e) {
+        assert(std::string(e.what()) == "Out of bounds");
+    }
+
+    // Optimized code leaves what the program as written leaves, at every width, on
+    // every backend.
+    std::mt19937 gen(25);
+    for (int round = 0; round < 400; ++round) {
+        program p = random_program(gen, 10 + round % 40);
+        BasicComputer<int16_t> c16(16);
+        BasicComputer<int32_t> c32(16, ooasm::Backend::parallel, 2);
+        Computer c64(16, ooasm::Backend::interpreter);
+        assert(run(c16, p) == lowered<int16_t>(p, 16));
+        assert(run(c32, p) == lowered<int32_t>(p, 16));
+        assert(run(c64, p) == lowered<int64_t>(p, 16));
+    }
+
+    // Binary dumps hold 64-bit cells whatever the width.
+    std::stringstream image16, image64;
+    computer16.memory_dump(image16, ooasm::dump_format::binary);
+    BasicComputer<int64_t> widened(6);
+    program same = {data("a", num(-32768)), data("b", num(4464)), one(mem(num(2))), one(mem(num(4))),
+                    mov(mem(num(5)), num(-1))};
+    widened.boot(same);
+    widened.memory_dump(image64, ooasm::dump_format::binary);
+    assert(image16.str() == image64.str());
+
+    // Batches over narrow words agree with computers over them.
+    program batch = {
+            data("a", num(0)),
+            data("p", num(0)),
+            dec(mem(lea("a"))),
+            ones(mem(num(2))),
+            add(mem(num(3)), num(32767)),
+            inc(mem(num(3))),
+            onez(mem(num(4))),
+            inc(mem(mem(lea("p")))),
+            mov(mem(num(5)), mem(mem(lea("p"))))
+    };
+    ooasm::BasicBatchComputer<int16_t> lanes(6, 3);
+    lanes.boot(batch, {{}, {32768, 3}, {-32767, 65537}});
+    const std::vector<std::vector<int64_t>> initial = {{0, 0}, {32768, 3}, {-32767, 65537}};
+    for (std::size_t lane = 0; lane < 3; ++lane) {
+        program single = {
+                data("a", num(initial[lane][0])),
+                data("p", num(initial[lane][1])),
+                dec(mem(lea("a"))),
+                ones(mem(num(2))),
+                add(mem(num(3)), num(32767)),
+                inc(mem(num(3))),
+                onez(mem(num(4))),
+                inc(mem(mem(lea("p")))),
+                mov(mem(num(5)), mem(mem(lea("p"))))
+        };
+        BasicComputer<int16_t> computer(6);
+        computer.boot(single);
+        std::stringstream ss;
+        lanes.memory_dump(lane, ss);
+        assert(!lanes.failed(lane));
+        assert(ss.str() == memory_dump(computer));
+    }
+}
@@ -0,0 +1,45 @@
+// Prints a trace flushed by ooasm::Tracer, one instruction per line, oldest first:
+//
+//   #41 position=17 cell=3 before=0 after=1 ZF=0 SF=1
+//   #42 position=18 skipped ZF=0 SF=1
+//
+// [#] is the sequence number of the instruction in the traced boots, [position] that of
+// its function in the program. Conditional writes not taken are shown as skipped.
+//
+// g++ -Wall -Wextra -O2 -std=c++17 -I../ooasm_ trace_decode.cc -o trace_decode
+// ./trace_decode trace.bin
+
+#include "tracer.h"
+#include <exception>
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::cerr << "usage: " << argv[0] << " TRACE\n";
+        return 2;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        std::cerr << argv[1] << ": cannot open\n";
+        return 1;
+    }
+
+    try {
+        ooasm::Trace trace = ooasm::read_trace(file);
+        uint64_t sequence = trace.first;
+        for (const auto &r : trace.records) {
+            std::cout << '#' << sequence++ << " position=" << r.position;
+            if (r.flags & ooasm::TraceRecord::wrote)
+                std::cout << " cell=" << r.address << " before=" << r.before << " after=" << r.after;
+            else
+                std::cout << " skipped";
+            std::cout << " ZF=" << ((r.flags & ooasm::TraceRecord::zero) ? 1 : 0)
+                      << " SF=" << ((r.flags & ooasm::TraceRecord::sign) ? 1 : 0) << '\n';
+        }
+    } catch (std::exception &e) {
+        std::cerr << argv[1] << ": " << e.what() << '\n';
+        return 1;
+    }
+}